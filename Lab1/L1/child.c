@@ -1,100 +1,196 @@
-#include <stdio.h>
-#include <unistd.h>
-#include <stdlib.h>
-#include <string.h>
-#include <fcntl.h>
-#include <errno.h>
-
-#define SIZE_BUF 4096
-#define SIZE_MSG 128
-
-//Функция для обработки ошибок и завершения программы
-void HandleError(const char *message) {
-    const char error_msg[] = "Error: "; // "Ошибка: "
-    write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
-    write(STDERR_FILENO, message, strlen(message));
-    write(STDERR_FILENO, "\n", 1);
-    exit(EXIT_FAILURE);
-}
-
-//Функция для записи суммы в файл
-void writeSumToFile(const char *filename, float sum) {
-    int fd = open(filename, O_WRONLY | O_CREAT | O_APPEND, 0644);
-    if (fd == -1) {
-        HandleError("opening the file"); // "открытие файла"
-    }
-
-    char sum_str[20];
-    int len = snprintf(sum_str, sizeof(sum_str), "%.2f\n", sum); // Output with 2 decimal places (Вывод с точностью до 2 знаков)
-    if (len < 0 || write(fd, sum_str, len) != len) {
-        close(fd);
-        HandleError("writing to the file"); // "запись в файл"
-    }
-
-    if (close(fd) == -1) {
-        HandleError("closing the file"); // "закрытие файла"
-    }
-}
-
-int main(int argc, char *argv[]) {
-    char buffer[SIZE_BUF];
-
-    // Check if a filename is provided as an argument (Проверяем, передано ли имя файла как аргумент)
-    if (argc < 2) {
-        const char error_msg[] = "You must specify a file name as an argument.\n"; // "Вы должны указать имя файла как аргумент"
-        write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
-        exit(EXIT_FAILURE);
-    }
-
-    char *filename = argv[1];
-
-    while (1) {
-        // Читаем ввод от родительского процесса
-        ssize_t bytesRead = read(STDIN_FILENO, buffer, sizeof(buffer) - 1);
-        if (bytesRead == -1) {
-            HandleError("reading input"); // "чтение входных данных"
-        }
-
-        if (bytesRead == 0) { // (EOF) Обнаружен конец ввода
-            break;
-        }
-
-        buffer[bytesRead] = '\0';
-        buffer[strcspn(buffer, "\n")] = 0; // Удаляем символ новой строки
-
-        if (strlen(buffer) == 0) {
-            continue; // Skip empty input Пропускаем пустой ввод)
-
-        }
-
-        if (strcmp(buffer, "end") == 0) {
-           break;
-        }
-
-
-        char *token;
-        float sum = 0.0f;
-        char *endptr;
-
-        // Parse and process input tokens (Разбираем и обрабатываем токены ввода)
-        token = strtok(buffer, " ");
-        while (token != NULL) {
-            errno = 0;
-            float num = strtof(token, &endptr); // Use strtof for float (Используем strtof для работы с float)
-
-            if (errno != 0 || *endptr != '\0') {
-                const char error_msg[] = "Invalid number in input. Skipping.\n"; // "Недопустимое число во входных данных. Пропуск."
-                write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
-            } else {
-                sum += num;
-            }
-
-            token = strtok(NULL, " ");
-        }
-
-        // Write the computed sum to the file (Записываем вычисленную сумму в файл)
-        writeSumToFile(filename, sum);
-    }
-
-    return 0;
-}
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "frame.h"
+#include "sum-line.h"
+#include "sum-writer.h"
+#include "../../Trace/trace.h"
+
+#define SIZE_BUF 4096
+#define SIZE_MSG 128
+
+//Функция для обработки ошибок и завершения программы
+void HandleError(const char *message) {
+    const char error_msg[] = "Error: "; // "Ошибка: "
+    write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+    write(STDERR_FILENO, message, strlen(message));
+    write(STDERR_FILENO, "\n", 1);
+    exit(EXIT_FAILURE);
+}
+
+// С --async строки уходят в sum-writer (io_uring или поток записи) и цикл разбора не ждёт диск
+sum_writer *asyncWriter = NULL;
+
+//Функция для записи суммы в файл
+void writeSumToFile(const char *filename, double sum) {
+    TRACE_SCOPE("write sum");
+    if (asyncWriter != NULL) {
+        char sum_str[64];
+        int len = formatSum(sum_str, sizeof(sum_str), sum);
+        if (len < 0 || sum_writer_append(asyncWriter, sum_str, len) != 0) {
+            HandleError("writing to the file"); // "запись в файл"
+        }
+        return;
+    }
+
+    int result = appendSumLine(filename, sum);
+    if (result != SUM_LINE_OK) {
+        HandleError(sumLineError(result)); // "открытие", "запись" или "закрытие файла"
+    }
+}
+
+// Перед блокирующим чтением отдаёт накопленные строки --async, чтобы они не ждали следующей пачки
+void flushWriter(void) {
+    if (asyncWriter != NULL && sum_writer_flush(asyncWriter) != 0) {
+        HandleError("writing to the file"); // "запись в файл"
+    }
+}
+
+// Читает ровно size байт; 0 - конец ввода до начала блока
+int readExact(int fd, void *data, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t bytesRead = read(fd, (char *) data + done, size - done);
+        if (bytesRead == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            HandleError("reading input"); // "чтение входных данных"
+        }
+        if (bytesRead == 0) {
+            if (done != 0) {
+                HandleError("truncated frame"); // "оборванный кадр"
+            }
+            return 0;
+        }
+        done += bytesRead;
+    }
+    return 1;
+}
+
+// Двоичный режим (--binary): кадры из frame.h суммируются прямо из буфера приёма без разбора текста
+void processFrames(const char *filename) {
+    void *payload = NULL;
+    size_t capacity = 0;
+    frame_header header;
+
+    while (1) {
+        flushWriter();
+        if (!readExact(STDIN_FILENO, &header, sizeof(header))) {
+            break;
+        }
+        long size = frame_payload_size(&header);
+        if (size < 0) {
+            HandleError("invalid frame header"); // "неверный заголовок кадра"
+        }
+        if (header.type == FRAME_END) {
+            break;
+        }
+
+        if ((size_t) size > capacity) {
+            free(payload);
+            payload = malloc(size);
+            if (payload == NULL) {
+                HandleError("allocating the frame buffer"); // "выделение буфера кадра"
+            }
+            capacity = size;
+        }
+        if (size > 0 && !readExact(STDIN_FILENO, payload, size)) {
+            HandleError("truncated frame"); // "оборванный кадр"
+        }
+
+        TRACE_BEGIN("sum frame");
+        double sum = frame_sum(&header, payload);
+        TRACE_END("sum frame");
+        writeSumToFile(filename, sum);
+    }
+
+    free(payload);
+}
+
+// Дожидается отложенных записей --async
+void closeWriter(void) {
+    if (asyncWriter != NULL && sum_writer_close(asyncWriter) != 0) {
+        HandleError("writing to the file"); // "запись в файл"
+    }
+    asyncWriter = NULL;
+}
+
+int main(int argc, char *argv[]) {
+    char buffer[SIZE_BUF];
+
+    // Check if a filename is provided as an argument (Проверяем, передано ли имя файла как аргумент)
+    if (argc < 2) {
+        const char error_msg[] = "You must specify a file name as an argument.\n"; // "Вы должны указать имя файла как аргумент"
+        write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+        exit(EXIT_FAILURE);
+    }
+
+    char *filename = argv[1];
+    int binary = 0;
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--binary") == 0) {
+            binary = 1;
+        } else if (strcmp(argv[i], "--async") == 0) {
+            asyncWriter = sum_writer_open(filename, SUM_WRITER_ASYNC);
+            if (asyncWriter == NULL) {
+                HandleError("opening the file"); // "открытие файла"
+            }
+        }
+    }
+
+    if (binary) {
+        processFrames(filename);
+        closeWriter();
+        return 0;
+    }
+
+    while (1) {
+        // Читаем ввод от родительского процесса
+        flushWriter();
+        TRACE_BEGIN("read input");
+        ssize_t bytesRead = read(STDIN_FILENO, buffer, sizeof(buffer) - 1);
+        TRACE_END("read input");
+        if (bytesRead == -1) {
+            HandleError("reading input"); // "чтение входных данных"
+        }
+
+        if (bytesRead == 0) { // (EOF) Обнаружен конец ввода
+            break;
+        }
+
+        buffer[bytesRead] = '\0';
+        buffer[strcspn(buffer, "\n")] = 0; // Удаляем символ новой строки
+
+        if (strlen(buffer) == 0) {
+            continue; // Skip empty input Пропускаем пустой ввод)
+
+        }
+
+        if (strcmp(buffer, "end") == 0) {
+           break;
+        }
+
+
+        // Parse and process input tokens (Разбираем и обрабатываем токены ввода)
+        int invalid;
+        TRACE_BEGIN("parse line");
+        float sum = sumLine(buffer, &invalid);
+        TRACE_END("parse line");
+        for (int i = 0; i < invalid; i++) {
+            const char error_msg[] = "Invalid number in input. Skipping.\n"; // "Недопустимое число во входных данных. Пропуск."
+            write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+        }
+
+        // Write the computed sum to the file (Записываем вычисленную сумму в файл)
+        writeSumToFile(filename, sum);
+    }
+
+    closeWriter();
+    return 0;
+}
@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include "frame.h"
+
+// Сборка: gcc -O2 -o frame-bench frame-bench.c
+//
+// Передаёт одни и те же записи через канал в дочерний процесс текстом (как parent -> child)
+// и кадрами frame.h, и сравнивает число записей в секунду. Текст разбирается так же, как в child.c:
+// strtok + strtof. Время включает запись, разбор и суммирование, но не подготовку данных.
+
+#define SIZE_MSG 128
+
+void HandleError(const char *message) {
+    const char error_msg[] = "Error: ";
+    write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+    write(STDERR_FILENO, message, strlen(message));
+    write(STDERR_FILENO, "\n", 1);
+    exit(EXIT_FAILURE);
+}
+
+void writeAll(int fd, const void *data, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t written = write(fd, (const char *) data + done, size - done);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            HandleError("writing to the pipe");
+        }
+        done += written;
+    }
+}
+
+int readExact(int fd, void *data, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t bytesRead = read(fd, (char *) data + done, size - done);
+        if (bytesRead == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            HandleError("reading from the pipe");
+        }
+        if (bytesRead == 0) {
+            return 0;
+        }
+        done += bytesRead;
+    }
+    return 1;
+}
+
+// Потребитель текстового формата: строка - запись
+double consumeText(int fd) {
+    FILE *input = fdopen(fd, "r");
+    char *line = NULL;
+    size_t capacity = 0;
+    double total = 0.0;
+
+    while (getline(&line, &capacity, input) != -1) {
+        line[strcspn(line, "\n")] = 0;
+        float sum = 0.0f;
+        char *endptr;
+        for (char *token = strtok(line, " "); token != NULL; token = strtok(NULL, " ")) {
+            float num = strtof(token, &endptr);
+            if (*endptr == '\0') {
+                sum += num;
+            }
+        }
+        total += sum;
+    }
+
+    free(line);
+    fclose(input);
+    return total;
+}
+
+// Потребитель кадров: сумма считается прямо из буфера приёма
+double consumeFrames(int fd) {
+    void *payload = NULL;
+    size_t capacity = 0;
+    frame_header header;
+    double total = 0.0;
+
+    while (readExact(fd, &header, sizeof(header))) {
+        long size = frame_payload_size(&header);
+        if (size < 0) {
+            HandleError("invalid frame header");
+        }
+        if (header.type == FRAME_END) {
+            break;
+        }
+        if ((size_t) size > capacity) {
+            free(payload);
+            payload = malloc(size);
+            if (payload == NULL) {
+                HandleError("allocating the frame buffer");
+            }
+            capacity = size;
+        }
+        if (size > 0 && !readExact(fd, payload, size)) {
+            HandleError("truncated frame");
+        }
+        total += frame_sum(&header, payload);
+    }
+
+    free(payload);
+    return total;
+}
+
+// Прогоняет data через канал в дочерний процесс; возвращает время и сумму, посчитанную потребителем
+double runPipe(const char *data, size_t size, int binary, double *total) {
+    int dataPipe[2], resultPipe[2];
+    if (pipe(dataPipe) == -1 || pipe(resultPipe) == -1) {
+        HandleError("creating pipes");
+    }
+
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        HandleError("fork");
+    }
+    if (pid == 0) {
+        close(dataPipe[1]);
+        close(resultPipe[0]);
+        double sum = binary ? consumeFrames(dataPipe[0]) : consumeText(dataPipe[0]);
+        writeAll(resultPipe[1], &sum, sizeof(sum));
+        _exit(EXIT_SUCCESS);
+    }
+
+    close(dataPipe[0]);
+    close(resultPipe[1]);
+    writeAll(dataPipe[1], data, size);
+    close(dataPipe[1]);
+
+    if (!readExact(resultPipe[0], total, sizeof(*total))) {
+        HandleError("reading the consumer result");
+    }
+    close(resultPipe[0]);
+    waitpid(pid, NULL, 0);
+
+    gettimeofday(&end, NULL);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+    return seconds > 0 ? seconds : 1e-6;
+}
+
+void outputResult(const char *label, long records, size_t bytes, double seconds, double total) {
+    char message[SIZE_MSG];
+    int len = snprintf(message, sizeof(message), "%s%.0f records/sec, %.1f MB/sec, sum %.2f\n", label,
+                       records / seconds, bytes / seconds / 1e6, total);
+    write(STDOUT_FILENO, message, len);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        const char usage_msg[] = "Usage: ./frame-bench <records> <values_per_record> [float32|float64] [seed]\n";
+        write(STDERR_FILENO, usage_msg, sizeof(usage_msg) - 1);
+        exit(EXIT_FAILURE);
+    }
+
+    long records = atol(argv[1]);
+    long values = atol(argv[2]);
+    uint16_t type = argc > 3 && strcmp(argv[3], "float64") == 0 ? FRAME_FLOAT64 : FRAME_FLOAT32;
+    srand(argc > 4 ? atoi(argv[4]) : 1);
+
+    if (records <= 0 || values <= 0 || values > FRAME_MAX_COUNT) {
+        HandleError("records and values per record must be positive");
+    }
+
+    // Текст - по строке "%.2f %.2f ...\n" на запись, как ввод пользователя в parent
+    size_t element = frame_element_size(type);
+    size_t frameSize = sizeof(frame_header) + values * element;
+    size_t textCapacity = records * values * 16 + records;
+    char *text = malloc(textCapacity);
+    char *frames = malloc(records * frameSize + sizeof(frame_header));
+    float *record32 = malloc(values * sizeof(float));
+    double *record64 = malloc(values * sizeof(double));
+    if (text == NULL || frames == NULL || record32 == NULL || record64 == NULL) {
+        HandleError("allocating the benchmark data");
+    }
+
+    size_t textSize = 0;
+    char *frame = frames;
+    for (long r = 0; r < records; r++) {
+        for (long v = 0; v < values; v++) {
+            int cents = rand() % 200001 - 100000;
+            record32[v] = cents / 100.0f;
+            record64[v] = cents / 100.0;
+            textSize += snprintf(text + textSize, textCapacity - textSize, v + 1 < values ? "%.2f " : "%.2f\n",
+                                 cents / 100.0);
+        }
+
+        frame_header header;
+        frame_header_init(&header, type, values);
+        memcpy(frame, &header, sizeof(header));
+        memcpy(frame + sizeof(header), type == FRAME_FLOAT64 ? (void *) record64 : (void *) record32,
+               values * element);
+        frame += frameSize;
+    }
+    frame_header end;
+    frame_header_init(&end, FRAME_END, 0);
+    memcpy(frame, &end, sizeof(end));
+    size_t framesSize = records * frameSize + sizeof(frame_header);
+
+    double textTotal, frameTotal;
+    double textSeconds = runPipe(text, textSize, 0, &textTotal);
+    double frameSeconds = runPipe(frames, framesSize, 1, &frameTotal);
+
+    outputResult("Text lines: ", records, textSize, textSeconds, textTotal);
+    outputResult(type == FRAME_FLOAT64 ? "Frames float64: " : "Frames float32: ", records, framesSize,
+                 frameSeconds, frameTotal);
+
+    char message[SIZE_MSG];
+    int len = snprintf(message, sizeof(message), "Speedup: %.2fx\n", textSeconds / frameSeconds);
+    write(STDOUT_FILENO, message, len);
+
+    free(text);
+    free(frames);
+    free(record32);
+    free(record64);
+    return 0;
+}
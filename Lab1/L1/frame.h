@@ -0,0 +1,119 @@
+#ifndef LAB1_FRAME_H
+#define LAB1_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Двоичный формат обмена числами между родителем и дочерним процессом (Lab1 - канал, Lab3 - общая память).
+// Кадр - заголовок frame_header и сразу за ним count упакованных float32 или float64
+// в порядке байт машины (оба процесса работают на одной машине).
+// Кадр FRAME_END без данных заменяет строку "end" текстового режима.
+
+#define FRAME_MAGIC 0x4D524646u  // "FFRM" в памяти little-endian
+#define FRAME_VERSION 1
+#define FRAME_MAX_COUNT (1u << 24)  // Ограничение на размер кадра от испорченного заголовка
+
+enum frame_type {
+    FRAME_FLOAT32 = 1,
+    FRAME_FLOAT64 = 2,
+    FRAME_END = 3
+};
+
+// 16 байт, чтобы данные float64 за заголовком оставались выровненными
+typedef struct frame_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t type;
+    uint32_t count;
+    uint32_t reserved;
+} frame_header;
+
+static inline size_t frame_element_size(uint16_t type) {
+    return type == FRAME_FLOAT64 ? sizeof(double) : type == FRAME_FLOAT32 ? sizeof(float) : 0;
+}
+
+static inline void frame_header_init(frame_header *header, uint16_t type, uint32_t count) {
+    header->magic = FRAME_MAGIC;
+    header->version = FRAME_VERSION;
+    header->type = type;
+    header->count = type == FRAME_END ? 0 : count;
+    header->reserved = 0;
+}
+
+// Размер данных за заголовком или -1, если заголовок не наш
+static inline long frame_payload_size(const frame_header *header) {
+    if (header->magic != FRAME_MAGIC || header->version != FRAME_VERSION) {
+        return -1;
+    }
+    if (header->type == FRAME_END) {
+        return 0;
+    }
+    size_t element = frame_element_size(header->type);
+    if (element == 0 || header->count > FRAME_MAX_COUNT) {
+        return -1;
+    }
+    return (long) (header->count * element);
+}
+
+// Суммирование прямо из буфера приёма. Восемь независимых сумм в векторном регистре позволяют
+// компилятору использовать SIMD без -ffast-math; memcpy снимает требования к выравниванию буфера.
+typedef float frame_float_vector __attribute__((vector_size(32)));
+typedef double frame_double_vector __attribute__((vector_size(32)));
+
+static inline float frame_sum_float32(const void *data, uint32_t count) {
+    const unsigned char *bytes = data;
+    frame_float_vector accumulator = {0};
+    uint32_t lanes = sizeof(frame_float_vector) / sizeof(float);
+    uint32_t i = 0;
+
+    for (; i + lanes <= count; i += lanes) {
+        frame_float_vector chunk;
+        memcpy(&chunk, bytes + (size_t) i * sizeof(float), sizeof(chunk));
+        accumulator += chunk;
+    }
+
+    float sum = 0.0f;
+    for (uint32_t lane = 0; lane < lanes; lane++) {
+        sum += accumulator[lane];
+    }
+    for (; i < count; i++) {
+        float value;
+        memcpy(&value, bytes + (size_t) i * sizeof(float), sizeof(value));
+        sum += value;
+    }
+    return sum;
+}
+
+static inline double frame_sum_float64(const void *data, uint32_t count) {
+    const unsigned char *bytes = data;
+    frame_double_vector accumulator = {0};
+    uint32_t lanes = sizeof(frame_double_vector) / sizeof(double);
+    uint32_t i = 0;
+
+    for (; i + lanes <= count; i += lanes) {
+        frame_double_vector chunk;
+        memcpy(&chunk, bytes + (size_t) i * sizeof(double), sizeof(chunk));
+        accumulator += chunk;
+    }
+
+    double sum = 0.0;
+    for (uint32_t lane = 0; lane < lanes; lane++) {
+        sum += accumulator[lane];
+    }
+    for (; i < count; i++) {
+        double value;
+        memcpy(&value, bytes + (size_t) i * sizeof(double), sizeof(value));
+        sum += value;
+    }
+    return sum;
+}
+
+static inline double frame_sum(const frame_header *header, const void *data) {
+    if (header->type == FRAME_FLOAT64) {
+        return frame_sum_float64(data, header->count);
+    }
+    return frame_sum_float32(data, header->count);
+}
+
+#endif
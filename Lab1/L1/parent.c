@@ -1,102 +1,155 @@
-#include <windows.h>
-#include <stdlib.h>
-#include <string.h>
-#include <stdio.h>
-
-#define SIZE_BUF 100
-#define SIZE_MSG 100
-#define SIZE_CMDLINE 256
-
-void HandleError(const char *message) {
-    DWORD errorCode = GetLastError();
-    char errorBuffer[SIZE_MSG];
-    snprintf(errorBuffer, SIZE_MSG, "%s (error code: %lu)\n", message, errorCode);
-    WriteFile(GetStdHandle(STD_ERROR_HANDLE), errorBuffer, strlen(errorBuffer), NULL, NULL);
-    exit(EXIT_FAILURE);
-}
-
-int main(int argc, char *argv[]) {
-    HANDLE pipeRead, pipeWrite;
-    PROCESS_INFORMATION pi;
-    STARTUPINFO si;
-    char buffer[SIZE_BUF];
-
-    if (argc < 2) {
-        const char error_msg[] = "You must specify a file name as an argument.\n";
-        WriteFile(GetStdHandle(STD_ERROR_HANDLE), error_msg, sizeof(error_msg) - 1, NULL, NULL);
-        exit(EXIT_FAILURE);
-    }
-
-    SECURITY_ATTRIBUTES sa = {sizeof(SECURITY_ATTRIBUTES), NULL, TRUE};
-
-    if (!CreatePipe(&pipeRead, &pipeWrite, &sa, 0)) {
-        HandleError("Failed to create pipe");
-    }
-
-    ZeroMemory(&si, sizeof(STARTUPINFO));
-    si.cb = sizeof(STARTUPINFO);
-    si.hStdInput = pipeRead;
-    si.hStdOutput = GetStdHandle(STD_OUTPUT_HANDLE);
-    si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
-    si.dwFlags |= STARTF_USESTDHANDLES;
-
-    ZeroMemory(&pi, sizeof(PROCESS_INFORMATION));
-
-    char cmdLine[SIZE_CMDLINE];
-    size_t len = strlen(argv[1]);
-    if (len >= sizeof(cmdLine) - 11) {
-        const char error_msg[] = "Argument is too long\n";
-        WriteFile(GetStdHandle(STD_ERROR_HANDLE), error_msg, sizeof(error_msg) - 1, NULL, NULL);
-        CloseHandle(pipeRead);
-        CloseHandle(pipeWrite);
-        exit(EXIT_FAILURE);
-    }
-
-    strcpy(cmdLine, "child.exe ");
-    strcat(cmdLine, argv[1]);
-
-    if (!CreateProcess(NULL, cmdLine, NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi)) {
-        HandleError("Failed to create process");
-        CloseHandle(pipeRead);
-        CloseHandle(pipeWrite);
-    }
-
-    CloseHandle(pipeRead);
-
-    while (1) {
-        const char prompt[] = "Enter numbers (or 'end' to finish): ";
-        if (!WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), prompt, sizeof(prompt) - 1, NULL, NULL)) {
-            HandleError("Failed to write prompt");
-        }
-
-        DWORD bytesRead;
-        if (!ReadFile(GetStdHandle(STD_INPUT_HANDLE), buffer, sizeof(buffer) - 1, &bytesRead, NULL)) {
-            HandleError("Failed to read input");
-        }
-
-        buffer[bytesRead] = '\0';
-        buffer[strcspn(buffer, "\r\n")] = '\0';
-
-        if (strcmp(buffer, "end") == 0) {
-            DWORD written;
-            if (!WriteFile(pipeWrite, "end\n", 4, &written, NULL)) {
-                HandleError("Failed to write 'end' to pipe");
-            }
-            CloseHandle(pipeWrite);
-            break;
-        }
-
-
-        DWORD written;
-        if (!WriteFile(pipeWrite, buffer, strlen(buffer), &written, NULL) ||
-            !WriteFile(pipeWrite, "\n", 1, &written, NULL)) {
-            HandleError("Failed to write to pipe");
-        }
-    }
-
-    WaitForSingleObject(pi.hProcess, INFINITE);
-    CloseHandle(pi.hProcess);
-    CloseHandle(pi.hThread);
-
-    return 0;
-}
+#include <windows.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+
+#include "frame.h"
+
+#define SIZE_BUF 100
+#define SIZE_MSG 100
+#define SIZE_CMDLINE 256
+
+void HandleError(const char *message) {
+    DWORD errorCode = GetLastError();
+    char errorBuffer[SIZE_MSG];
+    snprintf(errorBuffer, SIZE_MSG, "%s (error code: %lu)\n", message, errorCode);
+    WriteFile(GetStdHandle(STD_ERROR_HANDLE), errorBuffer, strlen(errorBuffer), NULL, NULL);
+    exit(EXIT_FAILURE);
+}
+
+// Разбирает строку один раз на стороне родителя и отправляет её кадром float32
+void WriteFrame(HANDLE pipe, char *line) {
+    struct {
+        frame_header header;
+        float values[SIZE_BUF];
+    } frame;
+    uint32_t count = 0;
+    char *endptr;
+
+    for (char *token = strtok(line, " \t"); token != NULL && count < SIZE_BUF; token = strtok(NULL, " \t")) {
+        errno = 0;
+        float value = strtof(token, &endptr);
+        if (errno == 0 && *endptr == '\0') {
+            frame.values[count++] = value;
+        } else {
+            // То же предупреждение, что печатает child.c в текстовом режиме
+            const char error_msg[] = "Invalid number in input. Skipping.\n"; // "Недопустимое число во входных данных. Пропуск."
+            WriteFile(GetStdHandle(STD_ERROR_HANDLE), error_msg, sizeof(error_msg) - 1, NULL, NULL);
+        }
+    }
+
+    frame_header_init(&frame.header, FRAME_FLOAT32, count);
+    DWORD written;
+    if (!WriteFile(pipe, &frame, sizeof(frame_header) + count * sizeof(float), &written, NULL)) {
+        HandleError("Failed to write frame to pipe");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    HANDLE pipeRead, pipeWrite;
+    PROCESS_INFORMATION pi;
+    STARTUPINFO si;
+    char buffer[SIZE_BUF];
+
+    if (argc < 2) {
+        const char error_msg[] = "You must specify a file name as an argument.\n";
+        WriteFile(GetStdHandle(STD_ERROR_HANDLE), error_msg, sizeof(error_msg) - 1, NULL, NULL);
+        exit(EXIT_FAILURE);
+    }
+
+    // parent.exe <file> --binary: числа идут в дочерний процесс кадрами frame.h вместо текста
+    int binary = argc > 2 && strcmp(argv[2], "--binary") == 0;
+
+    SECURITY_ATTRIBUTES sa = {sizeof(SECURITY_ATTRIBUTES), NULL, TRUE};
+
+    if (!CreatePipe(&pipeRead, &pipeWrite, &sa, 0)) {
+        HandleError("Failed to create pipe");
+    }
+
+    ZeroMemory(&si, sizeof(STARTUPINFO));
+    si.cb = sizeof(STARTUPINFO);
+    si.hStdInput = pipeRead;
+    si.hStdOutput = GetStdHandle(STD_OUTPUT_HANDLE);
+    si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+    si.dwFlags |= STARTF_USESTDHANDLES;
+
+    ZeroMemory(&pi, sizeof(PROCESS_INFORMATION));
+
+    char cmdLine[SIZE_CMDLINE];
+    size_t len = strlen(argv[1]);
+    if (len >= sizeof(cmdLine) - 20) {
+        const char error_msg[] = "Argument is too long\n";
+        WriteFile(GetStdHandle(STD_ERROR_HANDLE), error_msg, sizeof(error_msg) - 1, NULL, NULL);
+        CloseHandle(pipeRead);
+        CloseHandle(pipeWrite);
+        exit(EXIT_FAILURE);
+    }
+
+    strcpy(cmdLine, "child.exe ");
+    strcat(cmdLine, argv[1]);
+    if (binary) {
+        strcat(cmdLine, " --binary");
+    }
+
+    if (!CreateProcess(NULL, cmdLine, NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi)) {
+        HandleError("Failed to create process");
+        CloseHandle(pipeRead);
+        CloseHandle(pipeWrite);
+    }
+
+    CloseHandle(pipeRead);
+
+    while (1) {
+        const char prompt[] = "Enter numbers (or 'end' to finish): ";
+        if (!WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), prompt, sizeof(prompt) - 1, NULL, NULL)) {
+            HandleError("Failed to write prompt");
+        }
+
+        DWORD bytesRead;
+        if (!ReadFile(GetStdHandle(STD_INPUT_HANDLE), buffer, sizeof(buffer) - 1, &bytesRead, NULL)) {
+            HandleError("Failed to read input");
+        }
+
+        buffer[bytesRead] = '\0';
+        buffer[strcspn(buffer, "\r\n")] = '\0';
+
+        if (strcmp(buffer, "end") == 0) {
+            DWORD written;
+            BOOL ok;
+            if (binary) {
+                frame_header end;
+                frame_header_init(&end, FRAME_END, 0);
+                ok = WriteFile(pipeWrite, &end, sizeof(end), &written, NULL);
+            } else {
+                ok = WriteFile(pipeWrite, "end\n", 4, &written, NULL);
+            }
+            if (!ok) {
+                HandleError("Failed to write 'end' to pipe");
+            }
+            CloseHandle(pipeWrite);
+            break;
+        }
+
+        if (binary) {
+            // Пустую строку child.c в текстовом режиме пропускает - кадр для неё не отправляем
+            if (buffer[0] != '\0') {
+                WriteFrame(pipeWrite, buffer);
+            }
+            continue;
+        }
+
+
+        DWORD written;
+        if (!WriteFile(pipeWrite, buffer, strlen(buffer), &written, NULL) ||
+            !WriteFile(pipeWrite, "\n", 1, &written, NULL)) {
+            HandleError("Failed to write to pipe");
+        }
+    }
+
+    WaitForSingleObject(pi.hProcess, INFINITE);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+
+    return 0;
+}
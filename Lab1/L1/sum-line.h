@@ -0,0 +1,83 @@
+#ifndef LAB1_SUM_LINE_H
+#define LAB1_SUM_LINE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Разбор строки чисел и дозапись суммы в файл - общие для child.c и sum-server.c.
+// Ошибки возвращаются вызывающему: child завершается, а сервер не должен падать из-за одного клиента.
+
+// Сумма чисел строки, разделённых пробелами; строка портится разбором.
+// В *invalid - число токенов, которые не удалось разобрать (они пропускаются)
+static inline float sumLine(char *line, int *invalid) {
+    float sum = 0.0f;
+    char *saveptr;
+    char *endptr;
+
+    *invalid = 0;
+    for (char *token = strtok_r(line, " ", &saveptr); token != NULL; token = strtok_r(NULL, " ", &saveptr)) {
+        errno = 0;
+        float num = strtof(token, &endptr); // Use strtof for float (Используем strtof для работы с float)
+
+        if (errno != 0 || *endptr != '\0') {
+            (*invalid)++;
+        } else {
+            sum += num;
+        }
+    }
+    return sum;
+}
+
+// Формат строки результата: сумма с двумя знаками (Вывод с точностью до 2 знаков)
+static inline int formatSum(char *line, size_t size, double sum) {
+    return snprintf(line, size, "%.2f\n", sum);
+}
+
+// Коды ошибок appendSumLine - у каждого шага своё сообщение
+enum sum_line_error {
+    SUM_LINE_OK = 0,
+    SUM_LINE_OPEN_FAILED = -1,
+    SUM_LINE_WRITE_FAILED = -2,
+    SUM_LINE_CLOSE_FAILED = -3
+};
+
+static inline const char *sumLineError(int error) {
+    switch (error) {
+        case SUM_LINE_OPEN_FAILED:
+            return "opening the file"; // "открытие файла"
+        case SUM_LINE_CLOSE_FAILED:
+            return "closing the file"; // "закрытие файла"
+        default:
+            return "writing to the file"; // "запись в файл"
+    }
+}
+
+// Одна строка суммы в уже открытый файл
+static inline int writeSumLine(int fd, double sum) {
+    char sum_str[64];
+    int len = formatSum(sum_str, sizeof(sum_str), sum);
+    if (len < 0 || write(fd, sum_str, len) != len) {
+        return SUM_LINE_WRITE_FAILED;
+    }
+    return SUM_LINE_OK;
+}
+
+// open/write/close на каждую сумму; SUM_LINE_OK или код шага, на котором случилась ошибка
+static inline int appendSumLine(const char *filename, double sum) {
+    int fd = open(filename, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd == -1) {
+        return SUM_LINE_OPEN_FAILED;
+    }
+
+    if (writeSumLine(fd, sum) != SUM_LINE_OK) {
+        close(fd);
+        return SUM_LINE_WRITE_FAILED;
+    }
+    return close(fd) == -1 ? SUM_LINE_CLOSE_FAILED : SUM_LINE_OK;
+}
+
+#endif
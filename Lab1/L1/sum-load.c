@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "frame.h"
+
+// Сборка: gcc -O2 -o sum-load sum-load.c
+//
+// ./sum-load <socket_path> <clients> <lines_per_client> [--binary]
+//
+// Нагрузка для sum-server: один процесс открывает clients соединений, держит их все открытыми
+// и по кругу шлёт в каждое по строке "1.25 2.50 3.75" (или кадру из тех же трёх float32),
+// затем "end" / FRAME_END. Выводит скорость отправки и ожидаемую сумму для сверки с сервером.
+
+#define SIZE_MSG 160
+
+const float values[] = {1.25f, 2.50f, 3.75f};
+const char line[] = "1.25 2.50 3.75\n";
+
+void HandleError(const char *message) {
+    const char error_msg[] = "Error: ";
+    write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+    write(STDERR_FILENO, message, strlen(message));
+    write(STDERR_FILENO, "\n", 1);
+    exit(EXIT_FAILURE);
+}
+
+void writeAll(int fd, const void *data, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t written = write(fd, (const char *) data + done, size - done);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            HandleError("writing to the socket");
+        }
+        done += written;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        const char usage_msg[] = "Usage: ./sum-load <socket_path> <clients> <lines_per_client> [--binary]\n";
+        write(STDERR_FILENO, usage_msg, sizeof(usage_msg) - 1);
+        exit(EXIT_FAILURE);
+    }
+
+    long clients = atol(argv[2]);
+    long lines = atol(argv[3]);
+    int binary = argc > 4 && strcmp(argv[4], "--binary") == 0;
+    if (clients <= 0 || lines < 0) {
+        HandleError("clients must be positive and lines non-negative");
+    }
+
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    if (strlen(argv[1]) >= sizeof(address.sun_path)) {
+        HandleError("socket path is too long");
+    }
+    strcpy(address.sun_path, argv[1]);
+
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    int *sockets = malloc(clients * sizeof(int));
+    if (sockets == NULL) {
+        HandleError("allocating the socket table");
+    }
+
+    struct timeval start, connected, end;
+    gettimeofday(&start, NULL);
+    for (long i = 0; i < clients; i++) {
+        sockets[i] = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (sockets[i] == -1 || connect(sockets[i], (struct sockaddr *) &address, sizeof(address)) == -1) {
+            HandleError("connecting to the server");
+        }
+    }
+    gettimeofday(&connected, NULL);
+
+    struct {
+        frame_header header;
+        float values[3];
+    } frame;
+    frame_header_init(&frame.header, FRAME_FLOAT32, 3);
+    memcpy(frame.values, values, sizeof(values));
+    frame_header end_frame;
+    frame_header_init(&end_frame, FRAME_END, 0);
+
+    for (long round = 0; round < lines; round++) {
+        for (long i = 0; i < clients; i++) {
+            if (binary) {
+                writeAll(sockets[i], &frame, sizeof(frame));
+            } else {
+                writeAll(sockets[i], line, sizeof(line) - 1);
+            }
+        }
+    }
+    for (long i = 0; i < clients; i++) {
+        if (binary) {
+            writeAll(sockets[i], &end_frame, sizeof(end_frame));
+        } else {
+            writeAll(sockets[i], "end\n", 4);
+        }
+        close(sockets[i]);
+    }
+    gettimeofday(&end, NULL);
+
+    double connectSeconds = (connected.tv_sec - start.tv_sec) + (connected.tv_usec - start.tv_usec) / 1000000.0;
+    double sendSeconds = (end.tv_sec - connected.tv_sec) + (end.tv_usec - connected.tv_usec) / 1000000.0;
+    float lineSum = values[0] + values[1] + values[2];
+
+    char message[SIZE_MSG];
+    int len = snprintf(message, sizeof(message),
+                       "Connected %ld clients in %.3f s, sent %ld lines at %.0f lines/sec, expected total %.2f\n",
+                       clients, connectSeconds, clients * lines, clients * lines / (sendSeconds > 0 ? sendSeconds : 1e-9),
+                       (double) lineSum * clients * lines);
+    write(STDOUT_FILENO, message, len);
+
+    free(sockets);
+    return 0;
+}
@@ -0,0 +1,410 @@
+#define _GNU_SOURCE  // accept4
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <limits.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/un.h>
+
+#include "frame.h"
+#include "sum-line.h"
+#include "sum-writer.h"
+
+// Сборка: gcc -O2 -o sum-server sum-server.c sum-writer.c -pthread
+//
+// ./sum-server <socket_path> <output_file> [--per-client]
+//
+// Долгоживущий аналог child: один процесс принимает много клиентов через Unix-сокет и считает
+// суммы строк так же, как child.c. Клиент шлёт текстовые строки или кадры frame.h - формат
+// определяется по первым байтам соединения. "end" или кадр FRAME_END закрывают соединение.
+// Суммы пишутся в общий output_file строками "<номер клиента> <сумма>" через sum-writer,
+// а с --per-client - в output_file.<номер клиента> тем же форматом, что у child (файл открыт,
+// пока открыто соединение).
+//
+// epoll работает по фронту (EPOLLET), все сокеты неблокирующие: каждое событие дочитывается
+// до EAGAIN. Буфер соединения выделяется только под неполную строку или кадр, поэтому
+// простаивающий клиент стоит лишь дескриптор и структуру connection. Кадр длиннее
+// CONNECTION_MAX_FRAME закрывает соединение: без предела каждый клиент мог бы заставить
+// сервер буферизовать до FRAME_MAX_COUNT * 8 байт.
+
+#define SIZE_READ 65536
+#define SIZE_MSG 160
+#define MAX_EVENTS 256
+#define CONNECTION_BUFFER 256
+#define CONNECTION_MAX_LINE 4096  // Как SIZE_BUF в child.c
+#define CONNECTION_MAX_FRAME (1 << 20)  // Байт полезной нагрузки одного кадра
+
+enum connection_mode {
+    CONNECTION_UNKNOWN,
+    CONNECTION_TEXT,
+    CONNECTION_FRAMES
+};
+
+typedef struct connection {
+    int fd;
+    unsigned long id;
+    int mode;
+    int finished;  // Получен "end" или FRAME_END
+    int outputFd;  // Файл клиента в режиме --per-client, -1 - ещё не открыт
+    char *buffer;  // Неразобранный хвост
+    size_t length;
+    size_t capacity;
+    struct connection *prev;
+    struct connection *next;
+} connection;
+
+const char *outputName;
+int perClient = 0;
+sum_writer *sharedWriter = NULL;
+connection *connections = NULL;
+char readBuffer[SIZE_READ];
+
+unsigned long nextId = 1;
+unsigned long openConnections = 0;
+unsigned long peakConnections = 0;
+unsigned long sumsWritten = 0;
+unsigned long failedWrites = 0;
+double totalSum = 0.0;
+
+volatile sig_atomic_t stopping = 0;
+
+void HandleError(const char *message) {
+    const char error_msg[] = "Error: ";
+    write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+    write(STDERR_FILENO, message, strlen(message));
+    write(STDERR_FILENO, "\n", 1);
+    exit(EXIT_FAILURE);
+}
+
+void Warn(const char *message, unsigned long id) {
+    char warn_msg[SIZE_MSG];
+    int len = snprintf(warn_msg, sizeof(warn_msg), "Client %lu: %s\n", id, message);
+    write(STDERR_FILENO, warn_msg, len);
+}
+
+void onSignal(int signal) {
+    (void) signal;
+    stopping = 1;
+}
+
+void emitSum(connection *conn, double sum) {
+    int failed;
+    if (perClient) {
+        if (conn->outputFd == -1) {
+            char filename[PATH_MAX];
+            snprintf(filename, sizeof(filename), "%s.%lu", outputName, conn->id);
+            conn->outputFd = open(filename, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (conn->outputFd == -1) {
+                failedWrites++;
+                Warn("opening the file failed", conn->id);
+                return;
+            }
+        }
+        failed = writeSumLine(conn->outputFd, sum) != SUM_LINE_OK;
+    } else {
+        char line[SUM_WRITER_LINE];
+        int prefix = snprintf(line, sizeof(line), "%lu ", conn->id);
+        int len = prefix + formatSum(line + prefix, sizeof(line) - prefix, sum);
+        failed = sum_writer_append(sharedWriter, line, len) != 0;
+    }
+
+    if (failed) {
+        failedWrites++;
+        Warn("writing to the file failed", conn->id);
+        return;
+    }
+    sumsWritten++;
+    totalSum += sum;
+}
+
+// Разбирает полные строки или кадры из буфера; 0 - соединение надо закрыть
+int processBuffer(connection *conn) {
+    size_t position = 0;
+
+    if (conn->mode == CONNECTION_UNKNOWN) {
+        uint32_t magic = FRAME_MAGIC;
+        if (conn->length >= sizeof(magic)) {
+            conn->mode = memcmp(conn->buffer, &magic, sizeof(magic)) == 0 ? CONNECTION_FRAMES : CONNECTION_TEXT;
+        } else if (memchr(conn->buffer, '\n', conn->length) != NULL) {
+            conn->mode = CONNECTION_TEXT;
+        }
+    }
+
+    if (conn->mode == CONNECTION_TEXT) {
+        char *newline;
+        while (!conn->finished &&
+               (newline = memchr(conn->buffer + position, '\n', conn->length - position)) != NULL) {
+            char *line = conn->buffer + position;
+            *newline = '\0';
+            position = newline - conn->buffer + 1;
+            line[strcspn(line, "\r")] = '\0';
+
+            if (strlen(line) == 0) {
+                continue; // Пропускаем пустой ввод
+            }
+            if (strcmp(line, "end") == 0) {
+                conn->finished = 1;
+                break;
+            }
+
+            int invalid;
+            float sum = sumLine(line, &invalid);
+            if (invalid != 0) {
+                Warn("invalid number in input, skipping", conn->id);
+            }
+            emitSum(conn, sum);
+        }
+        if (conn->length - position > CONNECTION_MAX_LINE) {
+            Warn("line is too long", conn->id);
+            return 0;
+        }
+    } else if (conn->mode == CONNECTION_FRAMES) {
+        while (!conn->finished && conn->length - position >= sizeof(frame_header)) {
+            frame_header header;
+            memcpy(&header, conn->buffer + position, sizeof(header));
+            long size = frame_payload_size(&header);
+            if (size < 0) {
+                Warn("invalid frame header", conn->id);
+                return 0;
+            }
+            if (size > CONNECTION_MAX_FRAME) {
+                Warn("frame is too large", conn->id);
+                return 0;
+            }
+            if (header.type == FRAME_END) {
+                conn->finished = 1;
+                break;
+            }
+            if (conn->length - position < sizeof(header) + size) {
+                break;
+            }
+            emitSum(conn, frame_sum(&header, conn->buffer + position + sizeof(header)));
+            position += sizeof(header) + size;
+        }
+    }
+
+    // Оставляем только неполный хвост; пустой буфер отдаём, чтобы простаивающие клиенты не держали память
+    conn->length -= position;
+    if (conn->length == 0) {
+        free(conn->buffer);
+        conn->buffer = NULL;
+        conn->capacity = 0;
+    } else if (position != 0) {
+        memmove(conn->buffer, conn->buffer + position, conn->length);
+    }
+    return !conn->finished;
+}
+
+int appendInput(connection *conn, const char *data, size_t size) {
+    if (conn->length + size > conn->capacity) {
+        size_t capacity = conn->capacity ? conn->capacity : CONNECTION_BUFFER;
+        while (capacity < conn->length + size) {
+            capacity *= 2;
+        }
+        char *buffer = realloc(conn->buffer, capacity);
+        if (buffer == NULL) {
+            return -1;
+        }
+        conn->buffer = buffer;
+        conn->capacity = capacity;
+    }
+    memcpy(conn->buffer + conn->length, data, size);
+    conn->length += size;
+    return 0;
+}
+
+void closeConnection(connection *conn) {
+    // Последняя строка без перевода строки считается строкой, как у child при EOF
+    if (conn->mode != CONNECTION_FRAMES && !conn->finished && conn->length != 0 && appendInput(conn, "\n", 1) == 0) {
+        processBuffer(conn);
+    }
+
+    close(conn->fd);
+    if (conn->outputFd != -1 && close(conn->outputFd) == -1) {
+        failedWrites++;
+        Warn("closing the file failed", conn->id);
+    }
+    if (conn->prev != NULL) {
+        conn->prev->next = conn->next;
+    } else {
+        connections = conn->next;
+    }
+    if (conn->next != NULL) {
+        conn->next->prev = conn->prev;
+    }
+    free(conn->buffer);
+    free(conn);
+    openConnections--;
+}
+
+// По фронту: читаем, пока сокет не вернёт EAGAIN, иначе следующего события не будет
+void handleReadable(connection *conn) {
+    while (1) {
+        ssize_t bytesRead = read(conn->fd, readBuffer, sizeof(readBuffer));
+        if (bytesRead > 0) {
+            if (appendInput(conn, readBuffer, bytesRead) != 0) {
+                Warn("out of memory for the connection buffer", conn->id);
+                closeConnection(conn);
+                return;
+            }
+            if (!processBuffer(conn)) {
+                closeConnection(conn);
+                return;
+            }
+            continue;
+        }
+        if (bytesRead == -1 && errno == EINTR) {
+            continue;
+        }
+        if (bytesRead == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        closeConnection(conn); // EOF или ошибка
+        return;
+    }
+}
+
+void acceptClients(int listenFd, int epollFd) {
+    while (1) {
+        int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("accept4"); // EMFILE: ждём, пока закроется кто-то из клиентов
+            }
+            return;
+        }
+
+        connection *conn = calloc(1, sizeof(connection));
+        if (conn == NULL) {
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        conn->outputFd = -1;
+        conn->id = nextId++;
+
+        struct epoll_event event = {.events = EPOLLIN | EPOLLRDHUP | EPOLLET, .data.ptr = conn};
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            perror("epoll_ctl");
+            close(fd);
+            free(conn);
+            continue;
+        }
+
+        conn->next = connections;
+        if (connections != NULL) {
+            connections->prev = conn;
+        }
+        connections = conn;
+        if (++openConnections > peakConnections) {
+            peakConnections = openConnections;
+        }
+    }
+}
+
+// Клиентов может быть больше 1024 - поднимаем мягкий предел дескрипторов до жёсткого
+void raiseFileLimit(void) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        const char usage_msg[] = "Usage: ./sum-server <socket_path> <output_file> [--per-client]\n";
+        write(STDERR_FILENO, usage_msg, sizeof(usage_msg) - 1);
+        exit(EXIT_FAILURE);
+    }
+
+    const char *socketPath = argv[1];
+    outputName = argv[2];
+    perClient = argc > 3 && strcmp(argv[3], "--per-client") == 0;
+
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        HandleError("socket path is too long");
+    }
+    strcpy(address.sun_path, socketPath);
+
+    if (!perClient) {
+        sharedWriter = sum_writer_open(outputName, SUM_WRITER_ASYNC);
+        if (sharedWriter == NULL) {
+            HandleError("opening the file");
+        }
+    }
+
+    raiseFileLimit();
+    signal(SIGPIPE, SIG_IGN);
+    struct sigaction action = {.sa_handler = onSignal};
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd == -1) {
+        HandleError("creating the socket");
+    }
+    unlink(socketPath);
+    if (bind(listenFd, (struct sockaddr *) &address, sizeof(address)) == -1 || listen(listenFd, SOMAXCONN) == -1) {
+        HandleError("binding the socket");
+    }
+
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event listenEvent = {.events = EPOLLIN | EPOLLET, .data.ptr = NULL};
+    if (epollFd == -1 || epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &listenEvent) == -1) {
+        HandleError("creating epoll");
+    }
+
+    struct epoll_event events[MAX_EVENTS];
+    while (!stopping) {
+        int ready = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+        if (ready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            HandleError("waiting for events");
+        }
+
+        for (int i = 0; i < ready; i++) {
+            if (events[i].data.ptr == NULL) {
+                acceptClients(listenFd, epollFd);
+            } else {
+                // EPOLLHUP/EPOLLERR тоже дочитываем: read вернёт остаток данных, затем 0 или ошибку
+                handleReadable(events[i].data.ptr);
+            }
+        }
+        // Строки этой пачки событий уходят одним io_uring_enter до следующего ожидания
+        if (sharedWriter != NULL && sum_writer_flush(sharedWriter) != 0) {
+            failedWrites++;
+        }
+    }
+
+    while (connections != NULL) {
+        closeConnection(connections);
+    }
+    close(epollFd);
+    close(listenFd);
+    unlink(socketPath);
+
+    if (sharedWriter != NULL && sum_writer_close(sharedWriter) != 0) {
+        failedWrites++;
+    }
+
+    char message[SIZE_MSG];
+    int len = snprintf(message, sizeof(message),
+                       "Clients: %lu, peak connected: %lu, sums written: %lu, failed: %lu, total: %.2f\n", nextId - 1,
+                       peakConnections, sumsWritten, failedWrites, totalSum);
+    write(STDOUT_FILENO, message, len);
+    return failedWrites == 0 ? 0 : EXIT_FAILURE;
+}
@@ -0,0 +1,521 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#include "sum-writer.h"
+
+// Кольца io_uring без liburing: разметка берётся из io_uring_params после io_uring_setup
+typedef struct uring {
+    int ring_fd;
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+} uring;
+
+typedef struct slot {
+    char line[SUM_WRITER_LINE];
+    size_t length;
+    size_t written;
+    off_t offset;
+    double submitted;  // Время append в микросекундах
+} slot;
+
+struct sum_writer {
+    sum_writer_mode mode;
+    char *filename;
+    int fd;
+    off_t offset;  // Следующая строка пишется сюда (асинхронные режимы)
+    int failed;
+
+    slot *slots;  // Отображены отдельно, чтобы зарегистрировать их в io_uring целиком
+    int free_slots[SUM_WRITER_SLOTS];
+    int free_count;
+
+    uring ring;
+    int in_flight;
+    unsigned unsubmitted;  // В очереди отправки, но ещё не отданы ядру
+    size_t syscalls;
+
+    // Запасной поток: кольцо номеров буферов от append к потоку
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    int queue[SUM_WRITER_SLOTS];
+    int queue_head;
+    int queue_count;
+    int stopping;
+
+    double *latencies;
+    size_t latency_capacity;
+    size_t latency_count;
+};
+
+static double now_microseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+static void record_latency(sum_writer *writer, double submitted, double completed) {
+    if (writer->latency_count < writer->latency_capacity) {
+        writer->latencies[writer->latency_count++] = completed - submitted;
+    }
+}
+
+static int uring_setup(uring *ring, unsigned entries, struct io_uring_params *params) {
+    memset(params, 0, sizeof(*params));
+    ring->ring_fd = (int) syscall(__NR_io_uring_setup, entries, params);
+    if (ring->ring_fd < 0) {
+        return -1;
+    }
+
+    ring->sq_ring_size = params->sq_off.array + params->sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params->cq_off.cqes + params->cq_entries * sizeof(struct io_uring_cqe);
+    if (params->features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_ring_size > ring->sq_ring_size) {
+            ring->sq_ring_size = ring->cq_ring_size;
+        }
+        ring->cq_ring_size = ring->sq_ring_size;
+    }
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         ring->ring_fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED) {
+        close(ring->ring_fd);
+        return -1;
+    }
+    if (params->features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ring = ring->sq_ring;
+    } else {
+        ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             ring->ring_fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ring == MAP_FAILED) {
+            munmap(ring->sq_ring, ring->sq_ring_size);
+            close(ring->ring_fd);
+            return -1;
+        }
+    }
+
+    ring->sqes_size = params->sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->ring_fd,
+                      IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        if (ring->cq_ring != ring->sq_ring) {
+            munmap(ring->cq_ring, ring->cq_ring_size);
+        }
+        munmap(ring->sq_ring, ring->sq_ring_size);
+        close(ring->ring_fd);
+        return -1;
+    }
+
+    char *sq = ring->sq_ring;
+    char *cq = ring->cq_ring;
+    ring->sq_tail = (unsigned *) (sq + params->sq_off.tail);
+    ring->sq_mask = (unsigned *) (sq + params->sq_off.ring_mask);
+    ring->sq_array = (unsigned *) (sq + params->sq_off.array);
+    ring->cq_head = (unsigned *) (cq + params->cq_off.head);
+    ring->cq_tail = (unsigned *) (cq + params->cq_off.tail);
+    ring->cq_mask = (unsigned *) (cq + params->cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) (cq + params->cq_off.cqes);
+    return 0;
+}
+
+static void uring_teardown(uring *ring) {
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring != ring->sq_ring) {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->ring_fd);
+}
+
+static int uring_enter(uring *ring, unsigned submit, unsigned wait) {
+    int result;
+    do {
+        result = (int) syscall(__NR_io_uring_enter, ring->ring_fd, submit, wait,
+                               wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    } while (result < 0 && errno == EINTR);
+    return result;
+}
+
+// Ставит запись из зарегистрированного буфера index в зарегистрированный файл 0; отправит uring_flush
+static void uring_queue_slot(sum_writer *writer, int index) {
+    uring *ring = &writer->ring;
+    slot *entry = &writer->slots[index];
+    unsigned tail = *ring->sq_tail;
+    unsigned position = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[position];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->flags = IOSQE_FIXED_FILE;
+    sqe->fd = 0;
+    sqe->addr = (unsigned long) (entry->line + entry->written);
+    sqe->len = entry->length - entry->written;
+    sqe->off = entry->offset + entry->written;
+    sqe->buf_index = index;
+    sqe->user_data = index;
+
+    ring->sq_array[position] = position;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    writer->in_flight++;
+    writer->unsubmitted++;
+}
+
+// Забирает все готовые завершения без системного вызова; короткую запись ставит дописывать
+static void uring_reap(sum_writer *writer) {
+    uring *ring = &writer->ring;
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return;
+    }
+    double completed = now_microseconds();  // Одна отметка на всё, что появилось с прошлого просмотра
+
+    for (; head != tail; head++) {
+        struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+        int index = (int) cqe->user_data;
+        slot *entry = &writer->slots[index];
+        writer->in_flight--;
+
+        if (cqe->res < 0) {
+            writer->failed = 1;
+        } else if (entry->written + cqe->res < entry->length && cqe->res > 0) {
+            entry->written += cqe->res;
+            uring_queue_slot(writer, index);
+            writer->in_flight--;  // Запись та же, в полёте она уже учтена
+            continue;
+        } else if (entry->written + cqe->res < entry->length) {
+            writer->failed = 1;
+        }
+
+        record_latency(writer, entry->submitted, completed);
+        writer->free_slots[writer->free_count++] = index;
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+
+// Отдаёт ядру всё поставленное и, если wait, ждёт хотя бы одного завершения.
+// Запись в обычный файл часто завершается прямо внутри io_uring_enter - её сразу и забираем
+static int uring_flush(sum_writer *writer, int wait) {
+    do {
+        int result = uring_enter(&writer->ring, writer->unsubmitted, wait);
+        writer->syscalls++;
+        if (result < 0) {
+            return -1;
+        }
+        writer->unsubmitted -= (unsigned) result < writer->unsubmitted ? (unsigned) result : writer->unsubmitted;
+        wait = 0;
+        uring_reap(writer);
+    } while (writer->unsubmitted > 0);  // Дописывание коротких записей
+    return 0;
+}
+
+static int uring_open(sum_writer *writer) {
+    struct io_uring_params params;
+    if (uring_setup(&writer->ring, SUM_WRITER_SLOTS, &params) != 0) {
+        return -1;
+    }
+
+    struct iovec buffers[SUM_WRITER_SLOTS];
+    for (int i = 0; i < SUM_WRITER_SLOTS; i++) {
+        buffers[i].iov_base = writer->slots[i].line;
+        buffers[i].iov_len = SUM_WRITER_LINE;
+    }
+    if (syscall(__NR_io_uring_register, writer->ring.ring_fd, IORING_REGISTER_BUFFERS, buffers,
+                SUM_WRITER_SLOTS) != 0 ||
+        syscall(__NR_io_uring_register, writer->ring.ring_fd, IORING_REGISTER_FILES, &writer->fd, 1) != 0) {
+        uring_teardown(&writer->ring);
+        return -1;
+    }
+    return 0;
+}
+
+static void *writer_thread(void *arg) {
+    sum_writer *writer = arg;
+
+    pthread_mutex_lock(&writer->lock);
+    while (1) {
+        while (writer->queue_count == 0 && !writer->stopping) {
+            pthread_cond_wait(&writer->changed, &writer->lock);
+        }
+        if (writer->queue_count == 0) {
+            break;
+        }
+        int index = writer->queue[writer->queue_head];
+        pthread_mutex_unlock(&writer->lock);
+
+        slot *entry = &writer->slots[index];
+        int failed = 0;
+        size_t calls = 0;
+        while (entry->written < entry->length) {
+            ssize_t written = pwrite(writer->fd, entry->line + entry->written, entry->length - entry->written,
+                                     entry->offset + entry->written);
+            calls++;
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                failed = 1;
+                break;
+            }
+            entry->written += written;
+        }
+
+        pthread_mutex_lock(&writer->lock);
+        writer->failed |= failed;
+        writer->syscalls += calls;
+        record_latency(writer, entry->submitted, now_microseconds());
+        writer->queue_head = (writer->queue_head + 1) % SUM_WRITER_SLOTS;
+        writer->queue_count--;
+        writer->free_slots[writer->free_count++] = index;
+        pthread_cond_broadcast(&writer->changed);
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return NULL;
+}
+
+static int thread_open(sum_writer *writer) {
+    writer->queue_head = 0;
+    writer->queue_count = 0;
+    writer->stopping = 0;
+    if (pthread_mutex_init(&writer->lock, NULL) != 0) {
+        return -1;
+    }
+    if (pthread_cond_init(&writer->changed, NULL) != 0) {
+        pthread_mutex_destroy(&writer->lock);
+        return -1;
+    }
+    if (pthread_create(&writer->thread, NULL, writer_thread, writer) != 0) {
+        pthread_cond_destroy(&writer->changed);
+        pthread_mutex_destroy(&writer->lock);
+        return -1;
+    }
+    return 0;
+}
+
+sum_writer *sum_writer_open(const char *filename, sum_writer_mode mode) {
+    sum_writer *writer = calloc(1, sizeof(sum_writer));
+    if (writer == NULL) {
+        return NULL;
+    }
+    writer->mode = mode;
+    writer->fd = -1;
+
+    if (mode == SUM_WRITER_SYNC) {
+        writer->filename = strdup(filename);
+        if (writer->filename == NULL) {
+            free(writer);
+            return NULL;
+        }
+        return writer;
+    }
+
+    writer->fd = open(filename, O_WRONLY | O_CREAT, 0644);
+    if (writer->fd == -1) {
+        free(writer);
+        return NULL;
+    }
+    writer->offset = lseek(writer->fd, 0, SEEK_END);
+
+    writer->slots = mmap(NULL, SUM_WRITER_SLOTS * sizeof(slot), PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (writer->slots == MAP_FAILED || writer->offset == -1) {
+        if (writer->slots != MAP_FAILED) {
+            munmap(writer->slots, SUM_WRITER_SLOTS * sizeof(slot));
+        }
+        close(writer->fd);
+        free(writer);
+        return NULL;
+    }
+    for (int i = 0; i < SUM_WRITER_SLOTS; i++) {
+        writer->free_slots[i] = SUM_WRITER_SLOTS - 1 - i;
+    }
+    writer->free_count = SUM_WRITER_SLOTS;
+
+    int opened = -1;
+    if (mode == SUM_WRITER_URING || mode == SUM_WRITER_ASYNC) {
+        opened = uring_open(writer);
+        writer->mode = SUM_WRITER_URING;
+    }
+    if (opened != 0 && (mode == SUM_WRITER_THREAD || mode == SUM_WRITER_ASYNC)) {
+        opened = thread_open(writer);
+        writer->mode = SUM_WRITER_THREAD;
+    }
+    if (opened != 0) {
+        munmap(writer->slots, SUM_WRITER_SLOTS * sizeof(slot));
+        close(writer->fd);
+        free(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+sum_writer_mode sum_writer_backend(const sum_writer *writer) {
+    return writer->mode;
+}
+
+// Синхронный путь - то же, что writeSumToFile в child.c
+static int sync_append(sum_writer *writer, const char *line, size_t length) {
+    double submitted = now_microseconds();
+    writer->syscalls += 3;
+    int fd = open(writer->filename, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd == -1) {
+        return -1;
+    }
+    ssize_t written = write(fd, line, length);
+    if (close(fd) == -1 || written != (ssize_t) length) {
+        return -1;
+    }
+    record_latency(writer, submitted, now_microseconds());
+    return 0;
+}
+
+int sum_writer_append(sum_writer *writer, const char *line, size_t length) {
+    if (length > SUM_WRITER_LINE) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (writer->mode == SUM_WRITER_SYNC) {
+        return sync_append(writer, line, length);
+    }
+
+    double submitted = now_microseconds();
+    int index;
+
+    if (writer->mode == SUM_WRITER_URING) {
+        uring_reap(writer);
+        // Ждём завершения, только если все буферы в полёте
+        while (writer->free_count == 0) {
+            if (uring_flush(writer, 1) != 0) {
+                return -1;
+            }
+        }
+        index = writer->free_slots[--writer->free_count];
+    } else {
+        pthread_mutex_lock(&writer->lock);
+        while (writer->free_count == 0) {
+            pthread_cond_wait(&writer->changed, &writer->lock);
+        }
+        index = writer->free_slots[--writer->free_count];
+        pthread_mutex_unlock(&writer->lock);
+    }
+
+    slot *entry = &writer->slots[index];
+    memcpy(entry->line, line, length);
+    entry->length = length;
+    entry->written = 0;
+    entry->offset = writer->offset;
+    entry->submitted = submitted;
+    writer->offset += length;
+
+    if (writer->mode == SUM_WRITER_URING) {
+        uring_queue_slot(writer, index);
+        return writer->unsubmitted >= SUM_WRITER_BATCH ? uring_flush(writer, 0) : 0;
+    }
+
+    pthread_mutex_lock(&writer->lock);
+    writer->queue[(writer->queue_head + writer->queue_count) % SUM_WRITER_SLOTS] = index;
+    writer->queue_count++;
+    pthread_cond_broadcast(&writer->changed);
+    pthread_mutex_unlock(&writer->lock);
+    return 0;
+}
+
+int sum_writer_flush(sum_writer *writer) {
+    if (writer->mode == SUM_WRITER_URING && writer->unsubmitted > 0 && uring_flush(writer, 0) != 0) {
+        writer->failed = 1;
+        return -1;
+    }
+    return 0;
+}
+
+size_t sum_writer_syscalls(const sum_writer *writer) {
+    return writer->syscalls;
+}
+
+int sum_writer_track_latency(sum_writer *writer, size_t capacity) {
+    double *latencies = realloc(writer->latencies, capacity * sizeof(double));
+    if (latencies == NULL && capacity != 0) {
+        return -1;
+    }
+    writer->latencies = latencies;
+    writer->latency_capacity = capacity;
+    if (writer->latency_count > capacity) {
+        writer->latency_count = capacity;
+    }
+    return 0;
+}
+
+size_t sum_writer_latencies(const sum_writer *writer, const double **latencies) {
+    *latencies = writer->latencies;
+    return writer->latency_count;
+}
+
+int sum_writer_drain(sum_writer *writer) {
+    if (writer->mode == SUM_WRITER_URING) {
+        if (sum_writer_flush(writer) != 0) {
+            return -1;
+        }
+        while (writer->in_flight > 0) {
+            if (uring_flush(writer, 1) != 0) {
+                writer->failed = 1;
+                break;
+            }
+        }
+    } else if (writer->mode == SUM_WRITER_THREAD) {
+        pthread_mutex_lock(&writer->lock);
+        while (writer->queue_count > 0) {
+            pthread_cond_wait(&writer->changed, &writer->lock);
+        }
+        int failed = writer->failed;
+        pthread_mutex_unlock(&writer->lock);
+        return failed ? -1 : 0;
+    }
+    return writer->failed ? -1 : 0;
+}
+
+int sum_writer_close(sum_writer *writer) {
+    int result = sum_writer_drain(writer);
+
+    if (writer->mode == SUM_WRITER_URING) {
+        uring_teardown(&writer->ring);
+    } else if (writer->mode == SUM_WRITER_THREAD) {
+        pthread_mutex_lock(&writer->lock);
+        writer->stopping = 1;
+        pthread_cond_broadcast(&writer->changed);
+        pthread_mutex_unlock(&writer->lock);
+        pthread_join(writer->thread, NULL);
+        pthread_cond_destroy(&writer->changed);
+        pthread_mutex_destroy(&writer->lock);
+    }
+
+    if (writer->slots != NULL) {
+        munmap(writer->slots, SUM_WRITER_SLOTS * sizeof(slot));
+    }
+    if (writer->fd != -1 && close(writer->fd) == -1) {
+        result = -1;
+    }
+    free(writer->filename);
+    free(writer->latencies);
+    free(writer);
+    return result;
+}
@@ -0,0 +1,58 @@
+#ifndef LAB1_SUM_WRITER_H
+#define LAB1_SUM_WRITER_H
+
+#include <stddef.h>
+
+// Запись строк с суммами в файл результата без ожидания файловой системы в цикле разбора.
+//
+// SUM_WRITER_SYNC повторяет writeSumToFile: open/write/close на каждую строку.
+// SUM_WRITER_URING ставит IORING_OP_WRITE_FIXED из зарегистрированных буферов в зарегистрированный
+// файл и отправляет их одним io_uring_enter на SUM_WRITER_BATCH строк (или в sum_writer_flush).
+// Очередь завершений просматривается без системного вызова при каждом append и после каждой
+// отправки, и время завершения строки отмечается сразу, как только её запись появилась в очереди.
+// SUM_WRITER_THREAD - запасной вариант без io_uring: строки пишет отдельный поток.
+// SUM_WRITER_ASYNC выбирает io_uring, а если ядро его не даёт - поток.
+//
+// Асинхронные режимы сами ведут смещение в файле, поэтому строки ложатся в порядке
+// sum_writer_append, даже если завершения приходят в другом порядке. Файл должен писать один процесс.
+
+#define SUM_WRITER_SLOTS 64  // Строк в полёте одновременно
+#define SUM_WRITER_LINE 64  // Наибольшая длина строки
+#define SUM_WRITER_BATCH 16  // Строк на один io_uring_enter
+
+typedef enum sum_writer_mode {
+    SUM_WRITER_SYNC,
+    SUM_WRITER_URING,
+    SUM_WRITER_THREAD,
+    SUM_WRITER_ASYNC
+} sum_writer_mode;
+
+typedef struct sum_writer sum_writer;
+
+// NULL, если файл не открылся или выбранный режим недоступен
+sum_writer *sum_writer_open(const char *filename, sum_writer_mode mode);
+
+// Режим, который реально используется (для SUM_WRITER_ASYNC - URING или THREAD)
+sum_writer_mode sum_writer_backend(const sum_writer *writer);
+
+// Копирует строку и ставит её в очередь; ждёт только если все буферы заняты
+int sum_writer_append(sum_writer *writer, const char *line, size_t length);
+
+// Отправляет строки, которые ещё копятся в пачку. Вызывается перед тем, как надолго
+// заблокироваться (read из канала, epoll_wait), чтобы строки не ждали следующей пачки
+int sum_writer_flush(sum_writer *writer);
+
+// Системных вызовов записи с открытия: io_uring_enter, pwrite или open/write/close
+size_t sum_writer_syscalls(const sum_writer *writer);
+
+// Запоминать задержку (от append до завершения записи, в микросекундах) для первых capacity строк
+int sum_writer_track_latency(sum_writer *writer, size_t capacity);
+size_t sum_writer_latencies(const sum_writer *writer, const double **latencies);
+
+// Дожидается всех отправленных записей; -1, если какая-то запись не удалась
+int sum_writer_drain(sum_writer *writer);
+
+// sum_writer_drain и освобождение ресурсов
+int sum_writer_close(sum_writer *writer);
+
+#endif
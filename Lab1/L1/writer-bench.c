@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sum-writer.h"
+
+// Сборка: gcc -O2 -o writer-bench writer-bench.c sum-writer.c -pthread
+//
+// Пишет lines строк "%.2f\n" в файл каждым способом из sum-writer.h и выводит строки в секунду
+// (до полного завершения всех записей), p99 времени внутри sum_writer_append - столько цикл разбора
+// стоит на каждой строке, - p50/p99 задержки строки от append до записи в файл и число системных
+// вызовов записи на строку.
+
+#define SIZE_MSG 192
+
+void HandleError(const char *message) {
+    const char error_msg[] = "Error: ";
+    write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+    write(STDERR_FILENO, message, strlen(message));
+    write(STDERR_FILENO, "\n", 1);
+    exit(EXIT_FAILURE);
+}
+
+double nowSeconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int compareDoubles(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+const char *modeName(sum_writer_mode mode) {
+    switch (mode) {
+        case SUM_WRITER_SYNC:
+            return "sync";
+        case SUM_WRITER_URING:
+            return "io_uring";
+        case SUM_WRITER_THREAD:
+            return "thread";
+        default:
+            return "async";
+    }
+}
+
+void runBackend(const char *filename, sum_writer_mode mode, long lines) {
+    unlink(filename);
+    sum_writer *writer = sum_writer_open(filename, mode);
+    if (writer == NULL) {
+        char message[SIZE_MSG];
+        int len = snprintf(message, sizeof(message), "%-9s unavailable\n", modeName(mode));
+        write(STDOUT_FILENO, message, len);
+        return;
+    }
+
+    double *appendTimes = malloc(lines * sizeof(double));
+    if (appendTimes == NULL || sum_writer_track_latency(writer, lines) != 0) {
+        HandleError("allocating the latency buffer");
+    }
+
+    double start = nowSeconds();
+    for (long i = 0; i < lines; i++) {
+        char line[32];
+        int len = snprintf(line, sizeof(line), "%.2f\n", (i % 100000) / 100.0);
+        double appendStart = nowSeconds();
+        if (sum_writer_append(writer, line, len) != 0) {
+            HandleError("writing to the file");
+        }
+        appendTimes[i] = (nowSeconds() - appendStart) * 1e6;
+    }
+    if (sum_writer_drain(writer) != 0) {
+        HandleError("writing to the file");
+    }
+    double seconds = nowSeconds() - start;
+
+    const double *latencies;
+    size_t count = sum_writer_latencies(writer, &latencies);
+    double *sorted = malloc(count * sizeof(double));
+    if (sorted == NULL) {
+        HandleError("allocating the latency buffer");
+    }
+    memcpy(sorted, latencies, count * sizeof(double));
+    qsort(sorted, count, sizeof(double), compareDoubles);
+    qsort(appendTimes, lines, sizeof(double), compareDoubles);
+
+    char message[SIZE_MSG];
+    int len = snprintf(message, sizeof(message),
+                       "%-9s %10.0f lines/sec   append p99 %7.2f us   line p50 %7.2f us   line p99 %7.2f us"
+                       "   syscalls/line %5.2f\n",
+                       modeName(sum_writer_backend(writer)), lines / (seconds > 0 ? seconds : 1e-9),
+                       appendTimes[(long) (lines * 0.99)], count ? sorted[count / 2] : 0.0,
+                       count ? sorted[(size_t) (count * 0.99)] : 0.0,
+                       (double) sum_writer_syscalls(writer) / lines);
+    write(STDOUT_FILENO, message, len);
+
+    free(sorted);
+    free(appendTimes);
+    if (sum_writer_close(writer) != 0) {
+        HandleError("closing the file");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        const char usage_msg[] = "Usage: ./writer-bench <lines> <output_file> [sync|uring|thread]\n";
+        write(STDERR_FILENO, usage_msg, sizeof(usage_msg) - 1);
+        exit(EXIT_FAILURE);
+    }
+
+    long lines = atol(argv[1]);
+    const char *filename = argv[2];
+    if (lines <= 0) {
+        HandleError("line count must be positive");
+    }
+
+    if (argc > 3) {
+        sum_writer_mode mode = strcmp(argv[3], "uring") == 0    ? SUM_WRITER_URING
+                               : strcmp(argv[3], "thread") == 0 ? SUM_WRITER_THREAD
+                                                                : SUM_WRITER_SYNC;
+        runBackend(filename, mode, lines);
+        return 0;
+    }
+
+    runBackend(filename, SUM_WRITER_SYNC, lines);
+    runBackend(filename, SUM_WRITER_URING, lines);
+    runBackend(filename, SUM_WRITER_THREAD, lines);
+    return 0;
+}
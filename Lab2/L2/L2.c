@@ -1,162 +1,481 @@
-#include <pthread.h>
-#include <stdlib.h>
-#include <unistd.h>
-#include <stdio.h>
-#include <sys/time.h>
-#include <semaphore.h> 
-
-#define BUFFER_SIZE 64
-
-typedef struct task_data {
-    int* numbers;
-    int range_start;
-    int range_end;
-} task_data;
-
-int shared_min;
-int shared_max;
-sem_t active_threads;  // Семафор для ограничения потоков
-pthread_mutex_t min_max_mutex = PTHREAD_MUTEX_INITIALIZER;  // Мьютекс для защиты глобальных значений
-
-void* process_range(void* arg);
-void output_number(int fd, double number);  // Для вывода времени
-void output_int(int fd, int number);  // Для вывода целых чисел
-
-int main(int argc, char** argv) {
-    if (argc != 4) {
-        const char usage_msg[] = "Usage: ./program <array_length> <max_active_threads> <random_seed>\n";
-        write(STDERR_FILENO, usage_msg, sizeof(usage_msg) - 1);
-        _exit(EXIT_FAILURE);
-    }
-
-    long array_length = atol(argv[1]);
-    int max_active_threads = atoi(argv[2]);
-    unsigned int random_seed = atoi(argv[3]);
-
-    if (array_length <= 0 || max_active_threads <= 0) {
-        const char error_msg[] = "Error: Array length and max threads must be positive integers.\n";
-        write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
-        _exit(EXIT_FAILURE);
-    }
-
-    // Выделение памяти под массив
-    int* data_array = malloc(array_length * sizeof(int));
-    if (!data_array) {
-        const char error_msg[] = "Memory allocation failed for the array\n";
-        write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
-        _exit(EXIT_FAILURE);
-    }
-
-    srand(random_seed);
-    for (long i = 0; i < array_length; i++) {
-        data_array[i] = rand() % 1000;  // Заполнение массива случайными числами
-    }
-
-    pthread_t* thread_pool = malloc(max_active_threads * sizeof(pthread_t));
-    task_data* tasks = malloc(max_active_threads * sizeof(task_data));
-
-    sem_init(&active_threads, 0, max_active_threads);
-
-    shared_min = data_array[0];
-    shared_max = data_array[0];
-
-    struct timeval program_start, program_end;  // Структуры для времени в секундах
-    gettimeofday(&program_start, NULL);  // Засекаем время начала
-
-    int chunk_size = array_length / max_active_threads + (array_length % max_active_threads != 0);
-    int total_threads = 0;
-
-    for (int i = 0; i < max_active_threads; i++) {
-        tasks[i].numbers = data_array;
-        tasks[i].range_start = i * chunk_size;
-        tasks[i].range_end = (i == max_active_threads - 1) ? array_length : (i + 1) * chunk_size;
-
-        sem_wait(&active_threads);
-
-        if (pthread_create(&thread_pool[i], NULL, process_range, &tasks[i]) != 0) {
-            const char error_msg[] = "Thread creation failed\n";
-            write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
-            free(data_array);
-            _exit(EXIT_FAILURE);
-        }
-        total_threads++;
-    }
-
-    for (int i = 0; i < total_threads; i++) {
-        if (pthread_join(thread_pool[i], NULL) != 0) {
-            const char error_msg[] = "Thread joining failed\n";
-            write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
-            free(data_array);
-            _exit(EXIT_FAILURE);
-        }
-    }
-
-    gettimeofday(&program_end, NULL);  // Засекаем время окончания
-
-    // Вычисляем время в секундах
-    double exec_time_seconds = (program_end.tv_sec - program_start.tv_sec) +
-                               (program_end.tv_usec - program_start.tv_usec) / 1000000.0;
-
-    const char exec_time_msg[] = "Execution time: ";
-    write(STDOUT_FILENO, exec_time_msg, sizeof(exec_time_msg) - 1);
-    output_number(STDOUT_FILENO, exec_time_seconds);  // Выводим время в секундах
-    const char newline[] = " seconds\n";
-    write(STDOUT_FILENO, newline, sizeof(newline) - 1);
-
-    const char min_label[] = "Minimum value: ";
-    write(STDOUT_FILENO, min_label, sizeof(min_label) - 1);
-    output_int(STDOUT_FILENO, shared_min);  // Используем новую функцию для целых чисел
-    write(STDOUT_FILENO, "\n", 1);
-
-    const char max_label[] = "Maximum value: ";
-    write(STDOUT_FILENO, max_label, sizeof(max_label) - 1);
-    output_int(STDOUT_FILENO, shared_max);  // Используем новую функцию для целых чисел
-    write(STDOUT_FILENO, "\n", 1);
-
-    sem_destroy(&active_threads);
-    free(data_array);
-    free(thread_pool);
-    free(tasks);
-
-    return 0;
-}
-
-void* process_range(void* arg) {
-    task_data* task = (task_data*)arg;
-
-    int local_min = task->numbers[task->range_start];
-    int local_max = task->numbers[task->range_start];
-
-    for (int i = task->range_start; i < task->range_end; i++) {
-        if (task->numbers[i] < local_min)
-            local_min = task->numbers[i];
-        if (task->numbers[i] > local_max)
-            local_max = task->numbers[i];
-    }
-
-    // Используем мьютекс для безопасного обновления глобальных значений
-    pthread_mutex_lock(&min_max_mutex);
-    if (local_min < shared_min) {
-        shared_min = local_min;
-    }
-    if (local_max > shared_max) {
-        shared_max = local_max;
-    }
-    pthread_mutex_unlock(&min_max_mutex);
-
-    sem_post(&active_threads);
-    return NULL;
-}
-
-void output_number(int fd, double number) {
-    char buffer[BUFFER_SIZE];
-    int length = snprintf(buffer, sizeof(buffer), "%.6f", number);  // Вывод с 6 знаками после запятой
-    write(fd, buffer, length);
-}
-
-// Новая функция для вывода целых чисел
-void output_int(int fd, int number) {
-    char buffer[BUFFER_SIZE];
-    int length = snprintf(buffer, sizeof(buffer), "%d", number);  // Выводим как целое число
-    write(fd, buffer, length);
-}
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <semaphore.h> 
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "../../Trace/trace.h"
+
+#define BUFFER_SIZE 64
+#define STREAM_BUFFERS 8  // Число буферов в кольце потокового режима
+#define STREAM_BUFFER_SIZE 65536  // Чисел в одном буфере
+#define STREAM_READ_SIZE 65536  // Байт за один read
+#define STREAM_REPORT_INTERVAL 1.0  // Секунд между промежуточными отчётами
+
+typedef struct task_data {
+    int* numbers;
+    int range_start;
+    int range_end;
+} task_data;
+
+int shared_min;
+int shared_max;
+sem_t active_threads;  // Семафор для ограничения потоков
+pthread_mutex_t min_max_mutex = PTHREAD_MUTEX_INITIALIZER;  // Мьютекс для защиты глобальных значений
+
+// Очередь номеров буферов: свободные ждут чтения, заполненные - обработки.
+// В кольце лежат только номера буферов, поэтому STREAM_BUFFERS + 1 мест всегда хватает;
+// конец ввода - общий флаг closed, а не отдельные записи для каждого потока
+typedef struct stream_queue {
+    int items[STREAM_BUFFERS + 1];
+    int head;
+    int tail;
+    int closed;
+    sem_t available;
+    pthread_mutex_t lock;
+} stream_queue;
+
+typedef struct stream_state {
+    int* buffers[STREAM_BUFFERS];
+    int counts[STREAM_BUFFERS];
+    stream_queue free_buffers;
+    stream_queue filled_buffers;
+} stream_state;
+
+long shared_count;  // Сколько чисел обработано в потоковом режиме
+
+void* process_range(void* arg);
+void output_number(int fd, double number);  // Для вывода времени
+void output_int(int fd, int number);  // Для вывода целых чисел
+void output_long(int fd, long number);
+int run_stream(int max_active_threads, int binary_input);
+void warn_out_of_range(void);  // Текстовый поток: число не помещается в int
+
+int main(int argc, char** argv) {
+    // Потоковый режим: числа читаются из stdin, память ограничена кольцом буферов
+    if (argc >= 3 && argc <= 4 && strcmp(argv[1], "--stream") == 0) {
+        int max_active_threads = atoi(argv[2]);
+        int binary_input = argc == 4 && strcmp(argv[3], "int32") == 0;
+        if (max_active_threads <= 0 || (argc == 4 && !binary_input && strcmp(argv[3], "text") != 0)) {
+            const char error_msg[] = "Error: Max threads must be a positive integer, format is text or int32.\n";
+            write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+            _exit(EXIT_FAILURE);
+        }
+        return run_stream(max_active_threads, binary_input);
+    }
+
+    if (argc != 4) {
+        const char usage_msg[] = "Usage: ./program <array_length> <max_active_threads> <random_seed>\n"
+                                 "       ./program --stream <max_active_threads> [text|int32] < input\n";
+        write(STDERR_FILENO, usage_msg, sizeof(usage_msg) - 1);
+        _exit(EXIT_FAILURE);
+    }
+
+    long array_length = atol(argv[1]);
+    int max_active_threads = atoi(argv[2]);
+    unsigned int random_seed = atoi(argv[3]);
+
+    if (array_length <= 0 || max_active_threads <= 0) {
+        const char error_msg[] = "Error: Array length and max threads must be positive integers.\n";
+        write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+        _exit(EXIT_FAILURE);
+    }
+
+    // Выделение памяти под массив
+    int* data_array = malloc(array_length * sizeof(int));
+    if (!data_array) {
+        const char error_msg[] = "Memory allocation failed for the array\n";
+        write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+        _exit(EXIT_FAILURE);
+    }
+
+    srand(random_seed);
+    for (long i = 0; i < array_length; i++) {
+        data_array[i] = rand() % 1000;  // Заполнение массива случайными числами
+    }
+
+    pthread_t* thread_pool = malloc(max_active_threads * sizeof(pthread_t));
+    task_data* tasks = malloc(max_active_threads * sizeof(task_data));
+
+    sem_init(&active_threads, 0, max_active_threads);
+
+    shared_min = data_array[0];
+    shared_max = data_array[0];
+
+    struct timeval program_start, program_end;  // Структуры для времени в секундах
+    gettimeofday(&program_start, NULL);  // Засекаем время начала
+
+    int chunk_size = array_length / max_active_threads + (array_length % max_active_threads != 0);
+    int total_threads = 0;
+
+    for (int i = 0; i < max_active_threads; i++) {
+        tasks[i].numbers = data_array;
+        tasks[i].range_start = i * chunk_size;
+        tasks[i].range_end = (i == max_active_threads - 1) ? array_length : (i + 1) * chunk_size;
+
+        TRACE_BEGIN("wait active_threads");
+        sem_wait(&active_threads);
+        TRACE_END("wait active_threads");
+
+        if (pthread_create(&thread_pool[i], NULL, process_range, &tasks[i]) != 0) {
+            const char error_msg[] = "Thread creation failed\n";
+            write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+            free(data_array);
+            _exit(EXIT_FAILURE);
+        }
+        total_threads++;
+    }
+
+    for (int i = 0; i < total_threads; i++) {
+        if (pthread_join(thread_pool[i], NULL) != 0) {
+            const char error_msg[] = "Thread joining failed\n";
+            write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+            free(data_array);
+            _exit(EXIT_FAILURE);
+        }
+    }
+
+    gettimeofday(&program_end, NULL);  // Засекаем время окончания
+
+    // Вычисляем время в секундах
+    double exec_time_seconds = (program_end.tv_sec - program_start.tv_sec) +
+                               (program_end.tv_usec - program_start.tv_usec) / 1000000.0;
+
+    const char exec_time_msg[] = "Execution time: ";
+    write(STDOUT_FILENO, exec_time_msg, sizeof(exec_time_msg) - 1);
+    output_number(STDOUT_FILENO, exec_time_seconds);  // Выводим время в секундах
+    const char newline[] = " seconds\n";
+    write(STDOUT_FILENO, newline, sizeof(newline) - 1);
+
+    const char min_label[] = "Minimum value: ";
+    write(STDOUT_FILENO, min_label, sizeof(min_label) - 1);
+    output_int(STDOUT_FILENO, shared_min);  // Используем новую функцию для целых чисел
+    write(STDOUT_FILENO, "\n", 1);
+
+    const char max_label[] = "Maximum value: ";
+    write(STDOUT_FILENO, max_label, sizeof(max_label) - 1);
+    output_int(STDOUT_FILENO, shared_max);  // Используем новую функцию для целых чисел
+    write(STDOUT_FILENO, "\n", 1);
+
+    sem_destroy(&active_threads);
+    free(data_array);
+    free(thread_pool);
+    free(tasks);
+
+    return 0;
+}
+
+void* process_range(void* arg) {
+    task_data* task = (task_data*)arg;
+    TRACE_BEGIN("process_range");
+    TRACE_COUNTERS("process_range start");
+
+    int local_min = task->numbers[task->range_start];
+    int local_max = task->numbers[task->range_start];
+
+    for (int i = task->range_start; i < task->range_end; i++) {
+        if (task->numbers[i] < local_min)
+            local_min = task->numbers[i];
+        if (task->numbers[i] > local_max)
+            local_max = task->numbers[i];
+    }
+
+    // Используем мьютекс для безопасного обновления глобальных значений
+    TRACE_BEGIN("merge min/max");
+    pthread_mutex_lock(&min_max_mutex);
+    if (local_min < shared_min) {
+        shared_min = local_min;
+    }
+    if (local_max > shared_max) {
+        shared_max = local_max;
+    }
+    pthread_mutex_unlock(&min_max_mutex);
+    TRACE_END("merge min/max");
+
+    TRACE_COUNTERS("process_range end");
+    TRACE_END("process_range");
+    sem_post(&active_threads);
+    return NULL;
+}
+
+void output_number(int fd, double number) {
+    char buffer[BUFFER_SIZE];
+    int length = snprintf(buffer, sizeof(buffer), "%.6f", number);  // Вывод с 6 знаками после запятой
+    write(fd, buffer, length);
+}
+
+// Новая функция для вывода целых чисел
+void output_int(int fd, int number) {
+    char buffer[BUFFER_SIZE];
+    int length = snprintf(buffer, sizeof(buffer), "%d", number);  // Выводим как целое число
+    write(fd, buffer, length);
+}
+
+void output_long(int fd, long number) {
+    char buffer[BUFFER_SIZE];
+    int length = snprintf(buffer, sizeof(buffer), "%ld", number);
+    write(fd, buffer, length);
+}
+
+void queue_init(stream_queue* queue) {
+    queue->head = 0;
+    queue->tail = 0;
+    queue->closed = 0;
+    sem_init(&queue->available, 0, 0);
+    pthread_mutex_init(&queue->lock, NULL);
+}
+
+void queue_push(stream_queue* queue, int item) {
+    pthread_mutex_lock(&queue->lock);
+    queue->items[queue->tail] = item;
+    queue->tail = (queue->tail + 1) % (STREAM_BUFFERS + 1);
+    pthread_mutex_unlock(&queue->lock);
+    sem_post(&queue->available);
+}
+
+// Возвращает -1, если очередь закрыта и пуста
+int queue_pop(stream_queue* queue) {
+    sem_wait(&queue->available);
+    pthread_mutex_lock(&queue->lock);
+    if (queue->head == queue->tail && queue->closed) {
+        pthread_mutex_unlock(&queue->lock);
+        sem_post(&queue->available);  // Будим следующего ожидающего
+        return -1;
+    }
+    int item = queue->items[queue->head];
+    queue->head = (queue->head + 1) % (STREAM_BUFFERS + 1);
+    pthread_mutex_unlock(&queue->lock);
+    return item;
+}
+
+// Оставшиеся элементы ещё будут выданы, после них queue_pop вернёт -1 всем потокам
+void queue_close(stream_queue* queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->closed = 1;
+    pthread_mutex_unlock(&queue->lock);
+    sem_post(&queue->available);
+}
+
+void queue_destroy(stream_queue* queue) {
+    sem_destroy(&queue->available);
+    pthread_mutex_destroy(&queue->lock);
+}
+
+// Рабочий поток: берёт заполненный буфер, обрабатывает его через process_range и возвращает в кольцо
+void* stream_worker(void* arg) {
+    stream_state* state = (stream_state*)arg;
+
+    while (1) {
+        int index = queue_pop(&state->filled_buffers);
+        if (index < 0) {  // Ввод закончился
+            break;
+        }
+
+        task_data task = {state->buffers[index], 0, state->counts[index]};
+        sem_wait(&active_threads);  // process_range сам вернёт место в семафоре
+        process_range(&task);
+
+        pthread_mutex_lock(&min_max_mutex);
+        shared_count += state->counts[index];
+        pthread_mutex_unlock(&min_max_mutex);
+
+        queue_push(&state->free_buffers, index);
+    }
+    return NULL;
+}
+
+void report_stream(const char* label) {
+    pthread_mutex_lock(&min_max_mutex);
+    int current_min = shared_min;
+    int current_max = shared_max;
+    long current_count = shared_count;
+    pthread_mutex_unlock(&min_max_mutex);
+
+    write(STDOUT_FILENO, label, strlen(label));
+    output_long(STDOUT_FILENO, current_count);
+    if (current_count > 0) {
+        const char min_label[] = ", min ";
+        write(STDOUT_FILENO, min_label, sizeof(min_label) - 1);
+        output_int(STDOUT_FILENO, current_min);
+        const char max_label[] = ", max ";
+        write(STDOUT_FILENO, max_label, sizeof(max_label) - 1);
+        output_int(STDOUT_FILENO, current_max);
+    }
+    write(STDOUT_FILENO, "\n", 1);
+}
+
+void warn_out_of_range(void) {
+    const char error_msg[] = "Warning: number out of int range, skipping\n";
+    write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+}
+
+int run_stream(int max_active_threads, int binary_input) {
+    stream_state state;
+    unsigned char* input = malloc(STREAM_READ_SIZE + sizeof(int32_t));
+    pthread_t* thread_pool = malloc(max_active_threads * sizeof(pthread_t));
+    if (!input || !thread_pool) {
+        const char error_msg[] = "Memory allocation failed for the stream buffers\n";
+        write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+        _exit(EXIT_FAILURE);
+    }
+
+    queue_init(&state.free_buffers);
+    queue_init(&state.filled_buffers);
+    for (int i = 0; i < STREAM_BUFFERS; i++) {
+        state.buffers[i] = malloc(STREAM_BUFFER_SIZE * sizeof(int));
+        if (!state.buffers[i]) {
+            const char error_msg[] = "Memory allocation failed for the stream buffers\n";
+            write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+            _exit(EXIT_FAILURE);
+        }
+        queue_push(&state.free_buffers, i);
+    }
+
+    sem_init(&active_threads, 0, max_active_threads);
+    shared_min = INT_MAX;
+    shared_max = INT_MIN;
+    shared_count = 0;
+
+    for (int i = 0; i < max_active_threads; i++) {
+        if (pthread_create(&thread_pool[i], NULL, stream_worker, &state) != 0) {
+            const char error_msg[] = "Thread creation failed\n";
+            write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+            _exit(EXIT_FAILURE);
+        }
+    }
+
+    struct timeval program_start, last_report, now;
+    gettimeofday(&program_start, NULL);
+    last_report = program_start;
+
+    // Читатель: заполняет свободный буфер и отдаёт его рабочим, пока идёт чтение следующего.
+    // carry - хвост предыдущего read: незаконченное число в тексте или неполные 4 байта
+    int index = queue_pop(&state.free_buffers);
+    int count = 0;
+    size_t carry = 0;
+    int in_number = 0, negative = 0, out_of_range = 0;
+    long value = 0;
+    ssize_t bytes_read;
+
+    while ((bytes_read = read(STDIN_FILENO, input + carry, STREAM_READ_SIZE)) != 0) {
+        if (bytes_read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            const char error_msg[] = "Error reading input\n";
+            write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+            _exit(EXIT_FAILURE);
+        }
+
+        size_t available = carry + bytes_read;
+        size_t position = 0;
+        while (position < available) {
+            int have_value = 0;
+            int number = 0;
+            if (binary_input) {
+                if (available - position < sizeof(int32_t)) {
+                    break;
+                }
+                int32_t raw;
+                memcpy(&raw, input + position, sizeof(raw));
+                position += sizeof(raw);
+                number = raw;
+                have_value = 1;
+            } else {
+                unsigned char c = input[position++];
+                if (c >= '0' && c <= '9') {
+                    // Число вне int дальше не накапливаем - токен будет пропущен с предупреждением
+                    long limit = (long)INT_MAX + negative;
+                    if (out_of_range || value > (limit - (c - '0')) / 10) {
+                        out_of_range = 1;
+                    } else {
+                        value = value * 10 + (c - '0');
+                    }
+                    in_number = 1;
+                } else if (c == '-' && !in_number) {
+                    negative = 1;
+                } else {
+                    if (in_number && out_of_range) {
+                        warn_out_of_range();
+                    } else if (in_number) {
+                        number = (int)(negative ? -value : value);
+                        have_value = 1;
+                    }
+                    in_number = 0;
+                    negative = 0;
+                    out_of_range = 0;
+                    value = 0;
+                }
+            }
+
+            if (have_value) {
+                state.buffers[index][count++] = number;
+                if (count == STREAM_BUFFER_SIZE) {
+                    state.counts[index] = count;
+                    queue_push(&state.filled_buffers, index);
+                    index = queue_pop(&state.free_buffers);
+                    count = 0;
+                }
+            }
+        }
+
+        // Неполное двоичное число переносим в начало буфера чтения
+        carry = available - position;
+        memmove(input, input + position, carry);
+
+        gettimeofday(&now, NULL);
+        double since_report = (now.tv_sec - last_report.tv_sec) + (now.tv_usec - last_report.tv_usec) / 1000000.0;
+        if (since_report >= STREAM_REPORT_INTERVAL) {
+            report_stream("Processed: ");
+            last_report = now;
+        }
+    }
+
+    if (!binary_input && in_number && out_of_range) {
+        warn_out_of_range();
+    } else if (!binary_input && in_number) {
+        state.buffers[index][count++] = (int)(negative ? -value : value);
+    }
+    if (carry != 0) {
+        const char error_msg[] = "Warning: trailing bytes do not form a whole int32\n";
+        write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+    }
+    if (count > 0) {
+        state.counts[index] = count;
+        queue_push(&state.filled_buffers, index);
+    }
+    queue_close(&state.filled_buffers);
+
+    for (int i = 0; i < max_active_threads; i++) {
+        if (pthread_join(thread_pool[i], NULL) != 0) {
+            const char error_msg[] = "Thread joining failed\n";
+            write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+            _exit(EXIT_FAILURE);
+        }
+    }
+
+    gettimeofday(&now, NULL);
+    double exec_time_seconds = (now.tv_sec - program_start.tv_sec) +
+                               (now.tv_usec - program_start.tv_usec) / 1000000.0;
+    const char exec_time_msg[] = "Execution time: ";
+    write(STDOUT_FILENO, exec_time_msg, sizeof(exec_time_msg) - 1);
+    output_number(STDOUT_FILENO, exec_time_seconds);
+    const char newline[] = " seconds\n";
+    write(STDOUT_FILENO, newline, sizeof(newline) - 1);
+    report_stream("Total: ");
+
+    for (int i = 0; i < STREAM_BUFFERS; i++) {
+        free(state.buffers[i]);
+    }
+    queue_destroy(&state.free_buffers);
+    queue_destroy(&state.filled_buffers);
+    sem_destroy(&active_threads);
+    free(thread_pool);
+    free(input);
+    return 0;
+}
@@ -0,0 +1,43 @@
+#ifndef LAB2_PARALLEL_H
+#define LAB2_PARALLEL_H
+
+#include <pthread.h>
+#include <stdlib.h>
+
+// Общие помощники для range-index.c и selection.c: деление работы на части
+// и запуск одной функции в нескольких потоках.
+
+// Делит [0, total) на parts почти равных частей и возвращает границы части index
+static inline void split_range(long total, int parts, int index, long* start, long* end) {
+    long chunk = total / parts + (total % parts != 0);
+    *start = index * chunk < total ? index * chunk : total;
+    *end = (index + 1) * chunk < total ? (index + 1) * chunk : total;
+}
+
+static inline int clamp_threads(int threads, long work) {
+    if (threads < 1)
+        threads = 1;
+    if (threads > work)
+        threads = work > 0 ? (int)work : 1;
+    return threads;
+}
+
+// Запускает routine в threads потоках; tasks - массив из threads элементов размера task_size
+static inline int run_threads(void* (*routine)(void*), void* tasks, size_t task_size, int threads) {
+    pthread_t* thread_pool = malloc(threads * sizeof(pthread_t));
+    if (!thread_pool)
+        return -1;
+
+    int created = 0;
+    for (; created < threads; created++) {
+        if (pthread_create(&thread_pool[created], NULL, routine, (char*)tasks + created * task_size) != 0)
+            break;
+    }
+    for (int i = 0; i < created; i++) {
+        pthread_join(thread_pool[i], NULL);
+    }
+    free(thread_pool);
+    return created == threads ? 0 : -1;
+}
+
+#endif
@@ -0,0 +1,131 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include "selection.h"
+
+// Сборка: gcc -O2 -o quantiles quantiles.c selection.c -pthread -lm
+//
+// Считает p50/p99/p999 и k наибольших значений массива, заполненного как в L2.c,
+// и сверяет их с полной сортировкой в одном потоке.
+// value_range по умолчанию 1000 (rand() % 1000); при большем диапазоне включается
+// выбор по интервалам вместо гистограмм.
+
+#define BUFFER_SIZE 128
+#define QUANTILE_COUNT 3
+
+double elapsed_seconds(struct timeval* start, struct timeval* end);
+void output_line(const char* label, double value, const char* unit);
+int compare_ints(const void* a, const void* b);
+
+int main(int argc, char** argv) {
+    if (argc != 5 && argc != 6) {
+        const char usage_msg[] = "Usage: ./quantiles <array_length> <threads> <random_seed> <top_k> [value_range]\n";
+        write(STDERR_FILENO, usage_msg, sizeof(usage_msg) - 1);
+        _exit(EXIT_FAILURE);
+    }
+
+    long array_length = atol(argv[1]);
+    int threads = atoi(argv[2]);
+    unsigned int random_seed = atoi(argv[3]);
+    int top_k = atoi(argv[4]);
+    int value_range = argc == 6 ? atoi(argv[5]) : 1000;
+
+    if (array_length <= 0 || threads <= 0 || top_k <= 0 || top_k > array_length || value_range <= 0) {
+        const char error_msg[] = "Error: Arguments must be positive and top_k must not exceed array length.\n";
+        write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+        _exit(EXIT_FAILURE);
+    }
+
+    int* data_array = malloc(array_length * sizeof(int));
+    int* sorted = malloc(array_length * sizeof(int));
+    int* top = malloc(top_k * sizeof(int));
+    if (!data_array || !sorted || !top) {
+        const char error_msg[] = "Memory allocation failed\n";
+        write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+        _exit(EXIT_FAILURE);
+    }
+
+    srand(random_seed);
+    for (long i = 0; i < array_length; i++) {
+        data_array[i] = (int)(((long)rand() * RAND_MAX + rand()) % value_range);
+    }
+
+    const double quantiles[QUANTILE_COUNT] = {0.5, 0.99, 0.999};
+    const char* labels[QUANTILE_COUNT] = {"p50", "p99", "p999"};
+    int results[QUANTILE_COUNT];
+    struct timeval start, end;
+
+    gettimeofday(&start, NULL);
+    if (select_quantiles(data_array, array_length, quantiles, results, QUANTILE_COUNT, threads) != 0) {
+        const char error_msg[] = "Quantile selection failed\n";
+        write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+        _exit(EXIT_FAILURE);
+    }
+    gettimeofday(&end, NULL);
+    output_line("Quantile selection: ", elapsed_seconds(&start, &end), " seconds");
+
+    gettimeofday(&start, NULL);
+    if (select_top_k(data_array, array_length, top, top_k, threads) != 0) {
+        const char error_msg[] = "Top-k selection failed\n";
+        write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+        _exit(EXIT_FAILURE);
+    }
+    gettimeofday(&end, NULL);
+    output_line("Top-k selection: ", elapsed_seconds(&start, &end), " seconds");
+
+    gettimeofday(&start, NULL);
+    memcpy(sorted, data_array, array_length * sizeof(int));
+    qsort(sorted, array_length, sizeof(int), compare_ints);
+    gettimeofday(&end, NULL);
+    output_line("Full sort: ", elapsed_seconds(&start, &end), " seconds");
+
+    int mismatches = 0;
+    char buffer[BUFFER_SIZE];
+    for (int j = 0; j < QUANTILE_COUNT; j++) {
+        long rank = (long)ceil(quantiles[j] * array_length);
+        int expected = sorted[(rank > 0 ? rank : 1) - 1];
+        mismatches += results[j] != expected;
+        int length = snprintf(buffer, sizeof(buffer), "%s: %d\n", labels[j], results[j]);
+        write(STDOUT_FILENO, buffer, length);
+    }
+
+    const char top_label[] = "Top values:";
+    write(STDOUT_FILENO, top_label, sizeof(top_label) - 1);
+    for (int i = 0; i < top_k; i++) {
+        mismatches += top[i] != sorted[array_length - 1 - i];
+        if (i < 10) {
+            int length = snprintf(buffer, sizeof(buffer), " %d", top[i]);
+            write(STDOUT_FILENO, buffer, length);
+        }
+    }
+    write(STDOUT_FILENO, top_k > 10 ? " ...\n" : "\n", top_k > 10 ? 5 : 1);
+
+    if (mismatches != 0) {
+        const char error_msg[] = "Error: selection differs from full sort\n";
+        write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+    }
+
+    free(data_array);
+    free(sorted);
+    free(top);
+    return mismatches == 0 ? 0 : EXIT_FAILURE;
+}
+
+double elapsed_seconds(struct timeval* start, struct timeval* end) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_usec - start->tv_usec) / 1000000.0;
+}
+
+void output_line(const char* label, double value, const char* unit) {
+    char buffer[BUFFER_SIZE];
+    int length = snprintf(buffer, sizeof(buffer), "%s%.6f%s\n", label, value, unit);
+    write(STDOUT_FILENO, buffer, length);
+}
+
+int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
@@ -0,0 +1,169 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/time.h>
+
+#include "range-index.h"
+
+// Сборка: gcc -O2 -o range-bench range-bench.c range-index.c -pthread
+//
+// Сравнивает индексы из range-index.c с повторным просмотром каждого отрезка
+// тем же циклом, что и process_range в L2.c.
+
+#define BUFFER_SIZE 128
+#define RESCAN_LIMIT 2000  // Повторный просмотр медленный - меряем его на части запросов
+
+typedef struct task_data {
+    int* numbers;
+    long range_start;
+    long range_end;
+} task_data;
+
+double elapsed_seconds(struct timeval* start, struct timeval* end);
+void output_line(const char* label, double value, const char* unit);
+range_result rescan_range(task_data* task);
+
+int main(int argc, char** argv) {
+    if (argc != 5) {
+        const char usage_msg[] = "Usage: ./range-bench <array_length> <threads> <query_count> <random_seed>\n";
+        write(STDERR_FILENO, usage_msg, sizeof(usage_msg) - 1);
+        _exit(EXIT_FAILURE);
+    }
+
+    long array_length = atol(argv[1]);
+    int threads = atoi(argv[2]);
+    long query_count = atol(argv[3]);
+    unsigned int random_seed = atoi(argv[4]);
+
+    if (array_length <= 0 || threads <= 0 || query_count <= 0) {
+        const char error_msg[] = "Error: Array length, threads and query count must be positive integers.\n";
+        write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+        _exit(EXIT_FAILURE);
+    }
+
+    int* data_array = malloc(array_length * sizeof(int));
+    range_query* queries = malloc(query_count * sizeof(range_query));
+    range_result* table_results = malloc(query_count * sizeof(range_result));
+    range_result* tree_results = malloc(query_count * sizeof(range_result));
+    if (!data_array || !queries || !table_results || !tree_results) {
+        const char error_msg[] = "Memory allocation failed\n";
+        write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+        _exit(EXIT_FAILURE);
+    }
+
+    srand(random_seed);
+    for (long i = 0; i < array_length; i++) {
+        data_array[i] = rand() % 1000;  // Заполнение как в L2.c
+    }
+    for (long i = 0; i < query_count; i++) {
+        long a = ((long)rand() * RAND_MAX + rand()) % array_length;
+        long b = ((long)rand() * RAND_MAX + rand()) % array_length;
+        queries[i].left = a < b ? a : b;
+        queries[i].right = (a < b ? b : a) + 1;
+    }
+
+    struct timeval start, end;
+    range_table table;
+    range_tree tree;
+
+    gettimeofday(&start, NULL);
+    if (range_table_build(&table, data_array, array_length, threads) != 0) {
+        const char error_msg[] = "Sparse table build failed\n";
+        write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+        _exit(EXIT_FAILURE);
+    }
+    gettimeofday(&end, NULL);
+    output_line("Sparse table build: ", elapsed_seconds(&start, &end), " seconds");
+
+    gettimeofday(&start, NULL);
+    if (range_tree_build(&tree, data_array, array_length, threads) != 0) {
+        const char error_msg[] = "Segment tree build failed\n";
+        write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+        _exit(EXIT_FAILURE);
+    }
+    gettimeofday(&end, NULL);
+    output_line("Segment tree build: ", elapsed_seconds(&start, &end), " seconds");
+
+    gettimeofday(&start, NULL);
+    range_table_query_batch(&table, queries, table_results, query_count, threads);
+    gettimeofday(&end, NULL);
+    output_line("Sparse table queries: ", query_count / elapsed_seconds(&start, &end), " queries/sec");
+
+    gettimeofday(&start, NULL);
+    range_tree_query_batch(&tree, queries, tree_results, query_count, threads);
+    gettimeofday(&end, NULL);
+    output_line("Segment tree queries: ", query_count / elapsed_seconds(&start, &end), " queries/sec");
+
+    long rescan_count = query_count < RESCAN_LIMIT ? query_count : RESCAN_LIMIT;
+    long mismatches = 0;
+    gettimeofday(&start, NULL);
+    for (long i = 0; i < rescan_count; i++) {
+        task_data task = {data_array, queries[i].left, queries[i].right};
+        range_result expected = rescan_range(&task);
+        if (expected.min != table_results[i].min || expected.max != table_results[i].max ||
+            expected.min != tree_results[i].min || expected.max != tree_results[i].max) {
+            mismatches++;
+        }
+    }
+    gettimeofday(&end, NULL);
+    output_line("Rescan queries: ", rescan_count / elapsed_seconds(&start, &end), " queries/sec");
+
+    // Точечные обновления дерева и проверка запроса по всему массиву
+    gettimeofday(&start, NULL);
+    for (long i = 0; i < query_count; i++) {
+        range_tree_update(&tree, queries[i].left, rand() % 1000);
+    }
+    gettimeofday(&end, NULL);
+    output_line("Segment tree updates: ", query_count / elapsed_seconds(&start, &end), " updates/sec");
+
+    task_data whole = {data_array, 0, array_length};
+    range_result expected = rescan_range(&whole);
+    range_result actual = range_tree_query(&tree, 0, array_length);
+    if (expected.min != actual.min || expected.max != actual.max) {
+        mismatches++;
+    }
+
+    if (mismatches != 0) {
+        const char error_msg[] = "Error: index results differ from rescan\n";
+        write(STDERR_FILENO, error_msg, sizeof(error_msg) - 1);
+    }
+
+    range_table_destroy(&table);
+    range_tree_destroy(&tree);
+    free(data_array);
+    free(queries);
+    free(table_results);
+    free(tree_results);
+
+    return mismatches == 0 ? 0 : EXIT_FAILURE;
+}
+
+double elapsed_seconds(struct timeval* start, struct timeval* end) {
+    double seconds = (end->tv_sec - start->tv_sec) + (end->tv_usec - start->tv_usec) / 1000000.0;
+    return seconds > 0 ? seconds : 1e-6;
+}
+
+void output_line(const char* label, double value, const char* unit) {
+    char buffer[BUFFER_SIZE];
+    int length = snprintf(buffer, sizeof(buffer), "%s%.6f%s\n", label, value, unit);
+    write(STDOUT_FILENO, buffer, length);
+}
+
+// Тот же просмотр, что в process_range, только результат возвращается, а не сливается в общие min/max
+range_result rescan_range(task_data* task) {
+    int local_min = task->numbers[task->range_start];
+    int local_max = task->numbers[task->range_start];
+
+    for (long i = task->range_start; i < task->range_end; i++) {
+        if (task->numbers[i] < local_min)
+            local_min = task->numbers[i];
+        if (task->numbers[i] > local_max)
+            local_max = task->numbers[i];
+    }
+
+    range_result result = {local_min, local_max};
+    return result;
+}
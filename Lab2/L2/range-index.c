@@ -0,0 +1,346 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "range-index.h"
+#include "parallel.h"
+
+typedef struct table_task {
+    range_table* table;
+    long block_start;
+    long block_end;
+    int level;
+} table_task;
+
+typedef struct tree_task {
+    range_tree* tree;
+    long block_start;
+    long block_end;
+} tree_task;
+
+typedef struct batch_task {
+    const range_table* table;
+    const range_tree* tree;
+    const range_query* queries;
+    range_result* results;
+    long start;
+    long end;
+} batch_task;
+
+static int floor_log2(long value) {
+    return 63 - __builtin_clzl((unsigned long) value);
+}
+
+static range_result scan_range(const int* numbers, long left, long right) {
+    range_result result = {INT_MAX, INT_MIN};
+    for (long i = left; i < right; i++) {
+        if (numbers[i] < result.min)
+            result.min = numbers[i];
+        if (numbers[i] > result.max)
+            result.max = numbers[i];
+    }
+    return result;
+}
+
+static void merge_result(range_result* result, int min, int max) {
+    if (min < result->min)
+        result->min = min;
+    if (max > result->max)
+        result->max = max;
+}
+
+static void* build_table_blocks(void* arg) {
+    table_task* task = (table_task*)arg;
+    range_table* table = task->table;
+    const int* numbers = table->numbers;
+
+    for (long b = task->block_start; b < task->block_end; b++) {
+        long first = b * RANGE_BLOCK;
+        long last = first + RANGE_BLOCK < table->length ? first + RANGE_BLOCK : table->length;
+
+        int min = numbers[first], max = numbers[first];
+        for (long i = first; i < last; i++) {
+            if (numbers[i] < min)
+                min = numbers[i];
+            if (numbers[i] > max)
+                max = numbers[i];
+            table->prefix_min[i] = min;
+            table->prefix_max[i] = max;
+        }
+        table->level_min[0][b] = min;
+        table->level_max[0][b] = max;
+
+        min = numbers[last - 1];
+        max = numbers[last - 1];
+        for (long i = last - 1; i >= first; i--) {
+            if (numbers[i] < min)
+                min = numbers[i];
+            if (numbers[i] > max)
+                max = numbers[i];
+            table->suffix_min[i] = min;
+            table->suffix_max[i] = max;
+        }
+    }
+    return NULL;
+}
+
+static void* build_table_level(void* arg) {
+    table_task* task = (table_task*)arg;
+    range_table* table = task->table;
+    int k = task->level;
+
+    long half = 1L << (k - 1);
+    long limit = table->block_count - (1L << k) + 1;
+    for (long b = task->block_start; b < task->block_end && b < limit; b++) {
+        int left_min = table->level_min[k - 1][b], right_min = table->level_min[k - 1][b + half];
+        int left_max = table->level_max[k - 1][b], right_max = table->level_max[k - 1][b + half];
+        table->level_min[k][b] = left_min < right_min ? left_min : right_min;
+        table->level_max[k][b] = left_max > right_max ? left_max : right_max;
+    }
+    return NULL;
+}
+
+int range_table_build(range_table* table, const int* numbers, long length, int threads) {
+    if (length <= 0)
+        return -1;
+
+    table->numbers = numbers;
+    table->length = length;
+    table->block_count = (length + RANGE_BLOCK - 1) / RANGE_BLOCK;
+    table->levels = floor_log2(table->block_count) + 1;
+    table->prefix_min = malloc(length * sizeof(int));
+    table->prefix_max = malloc(length * sizeof(int));
+    table->suffix_min = malloc(length * sizeof(int));
+    table->suffix_max = malloc(length * sizeof(int));
+    table->level_min = calloc(table->levels, sizeof(int*));
+    table->level_max = calloc(table->levels, sizeof(int*));
+    if (!table->prefix_min || !table->prefix_max || !table->suffix_min || !table->suffix_max ||
+        !table->level_min || !table->level_max) {
+        range_table_destroy(table);
+        return -1;
+    }
+    for (int k = 0; k < table->levels; k++) {
+        long count = table->block_count - (1L << k) + 1;
+        table->level_min[k] = malloc(count * sizeof(int));
+        table->level_max[k] = malloc(count * sizeof(int));
+        if (!table->level_min[k] || !table->level_max[k]) {
+            range_table_destroy(table);
+            return -1;
+        }
+    }
+
+    threads = clamp_threads(threads, table->block_count);
+    table_task* tasks = malloc(threads * sizeof(table_task));
+    if (!tasks) {
+        range_table_destroy(table);
+        return -1;
+    }
+    for (int i = 0; i < threads; i++) {
+        tasks[i].table = table;
+        tasks[i].level = 0;
+        split_range(table->block_count, threads, i, &tasks[i].block_start, &tasks[i].block_end);
+    }
+
+    // Уровень k строится из уровня k - 1, поэтому каждый уровень - отдельный проход потоков
+    int status = run_threads(build_table_blocks, tasks, sizeof(table_task), threads);
+    for (int k = 1; k < table->levels && status == 0; k++) {
+        for (int i = 0; i < threads; i++)
+            tasks[i].level = k;
+        status = run_threads(build_table_level, tasks, sizeof(table_task), threads);
+    }
+    free(tasks);
+    if (status != 0)
+        range_table_destroy(table);
+    return status;
+}
+
+range_result range_table_query(const range_table* table, long left, long right) {
+    long first_block = left / RANGE_BLOCK;
+    long last_block = (right - 1) / RANGE_BLOCK;
+    if (first_block == last_block)
+        return scan_range(table->numbers, left, right);
+
+    range_result result = {table->suffix_min[left], table->suffix_max[left]};
+    merge_result(&result, table->prefix_min[right - 1], table->prefix_max[right - 1]);
+
+    long count = last_block - first_block - 1;
+    if (count > 0) {
+        int k = floor_log2(count);
+        long from = first_block + 1;
+        long to = last_block - (1L << k);
+        merge_result(&result, table->level_min[k][from], table->level_max[k][from]);
+        merge_result(&result, table->level_min[k][to], table->level_max[k][to]);
+    }
+    return result;
+}
+
+void range_table_destroy(range_table* table) {
+    free(table->prefix_min);
+    free(table->prefix_max);
+    free(table->suffix_min);
+    free(table->suffix_max);
+    if (table->level_min) {
+        for (int k = 0; k < table->levels; k++)
+            free(table->level_min[k]);
+    }
+    if (table->level_max) {
+        for (int k = 0; k < table->levels; k++)
+            free(table->level_max[k]);
+    }
+    free(table->level_min);
+    free(table->level_max);
+    table->prefix_min = table->prefix_max = table->suffix_min = table->suffix_max = NULL;
+    table->level_min = table->level_max = NULL;
+}
+
+static void* build_tree_leaves(void* arg) {
+    tree_task* task = (tree_task*)arg;
+    range_tree* tree = task->tree;
+
+    for (long b = task->block_start; b < task->block_end; b++) {
+        long first = b * RANGE_BLOCK;
+        long last = first + RANGE_BLOCK < tree->length ? first + RANGE_BLOCK : tree->length;
+        range_result block = scan_range(tree->numbers, first, last);
+        tree->tree_min[tree->leaves + b] = block.min;
+        tree->tree_max[tree->leaves + b] = block.max;
+    }
+    return NULL;
+}
+
+int range_tree_build(range_tree* tree, int* numbers, long length, int threads) {
+    if (length <= 0)
+        return -1;
+
+    tree->numbers = numbers;
+    tree->length = length;
+    tree->block_count = (length + RANGE_BLOCK - 1) / RANGE_BLOCK;
+    tree->leaves = 1;
+    while (tree->leaves < tree->block_count)
+        tree->leaves *= 2;
+    tree->tree_min = malloc(2 * tree->leaves * sizeof(int));
+    tree->tree_max = malloc(2 * tree->leaves * sizeof(int));
+    if (!tree->tree_min || !tree->tree_max) {
+        range_tree_destroy(tree);
+        return -1;
+    }
+    for (long i = tree->leaves + tree->block_count; i < 2 * tree->leaves; i++) {
+        tree->tree_min[i] = INT_MAX;
+        tree->tree_max[i] = INT_MIN;
+    }
+
+    threads = clamp_threads(threads, tree->block_count);
+    tree_task* tasks = malloc(threads * sizeof(tree_task));
+    if (!tasks) {
+        range_tree_destroy(tree);
+        return -1;
+    }
+    for (int i = 0; i < threads; i++) {
+        tasks[i].tree = tree;
+        split_range(tree->block_count, threads, i, &tasks[i].block_start, &tasks[i].block_end);
+    }
+    int status = run_threads(build_tree_leaves, tasks, sizeof(tree_task), threads);
+    free(tasks);
+    if (status != 0) {
+        range_tree_destroy(tree);
+        return status;
+    }
+
+    // Внутренних узлов в RANGE_BLOCK раз меньше, чем элементов - достраиваем их в одном потоке
+    for (long i = tree->leaves - 1; i >= 1; i--) {
+        int left_min = tree->tree_min[2 * i], right_min = tree->tree_min[2 * i + 1];
+        int left_max = tree->tree_max[2 * i], right_max = tree->tree_max[2 * i + 1];
+        tree->tree_min[i] = left_min < right_min ? left_min : right_min;
+        tree->tree_max[i] = left_max > right_max ? left_max : right_max;
+    }
+    return 0;
+}
+
+void range_tree_update(range_tree* tree, long index, int value) {
+    tree->numbers[index] = value;
+
+    long block = index / RANGE_BLOCK;
+    long first = block * RANGE_BLOCK;
+    long last = first + RANGE_BLOCK < tree->length ? first + RANGE_BLOCK : tree->length;
+    range_result leaf = scan_range(tree->numbers, first, last);
+
+    long node = tree->leaves + block;
+    tree->tree_min[node] = leaf.min;
+    tree->tree_max[node] = leaf.max;
+    for (node /= 2; node >= 1; node /= 2) {
+        int left_min = tree->tree_min[2 * node], right_min = tree->tree_min[2 * node + 1];
+        int left_max = tree->tree_max[2 * node], right_max = tree->tree_max[2 * node + 1];
+        tree->tree_min[node] = left_min < right_min ? left_min : right_min;
+        tree->tree_max[node] = left_max > right_max ? left_max : right_max;
+    }
+}
+
+range_result range_tree_query(const range_tree* tree, long left, long right) {
+    long first_block = left / RANGE_BLOCK;
+    long last_block = (right - 1) / RANGE_BLOCK;
+    if (first_block == last_block)
+        return scan_range(tree->numbers, left, right);
+
+    range_result result = scan_range(tree->numbers, left, (first_block + 1) * RANGE_BLOCK);
+    range_result tail = scan_range(tree->numbers, last_block * RANGE_BLOCK, right);
+    merge_result(&result, tail.min, tail.max);
+
+    // Блоки [first_block + 1, last_block) - обход дерева снизу вверх
+    for (long lo = tree->leaves + first_block + 1, hi = tree->leaves + last_block; lo < hi; lo /= 2, hi /= 2) {
+        if (lo & 1) {
+            merge_result(&result, tree->tree_min[lo], tree->tree_max[lo]);
+            lo++;
+        }
+        if (hi & 1) {
+            hi--;
+            merge_result(&result, tree->tree_min[hi], tree->tree_max[hi]);
+        }
+    }
+    return result;
+}
+
+void range_tree_destroy(range_tree* tree) {
+    free(tree->tree_min);
+    free(tree->tree_max);
+    tree->tree_min = tree->tree_max = NULL;
+}
+
+static void* query_batch_range(void* arg) {
+    batch_task* task = (batch_task*)arg;
+    for (long i = task->start; i < task->end; i++) {
+        const range_query* query = &task->queries[i];
+        task->results[i] = task->table ? range_table_query(task->table, query->left, query->right)
+                                       : range_tree_query(task->tree, query->left, query->right);
+    }
+    return NULL;
+}
+
+static void query_batch(const range_table* table, const range_tree* tree, const range_query* queries,
+                        range_result* results, long count, int threads) {
+    threads = clamp_threads(threads, count);
+    batch_task* tasks = malloc(threads * sizeof(batch_task));
+    if (tasks) {
+        for (int i = 0; i < threads; i++) {
+            tasks[i].table = table;
+            tasks[i].tree = tree;
+            tasks[i].queries = queries;
+            tasks[i].results = results;
+            split_range(count, threads, i, &tasks[i].start, &tasks[i].end);
+        }
+    }
+    if (!tasks || run_threads(query_batch_range, tasks, sizeof(batch_task), threads) != 0) {
+        // Потоки не создались - отвечаем на всё в текущем потоке
+        batch_task whole = {table, tree, queries, results, 0, count};
+        query_batch_range(&whole);
+    }
+    free(tasks);
+}
+
+void range_table_query_batch(const range_table* table, const range_query* queries, range_result* results,
+                             long count, int threads) {
+    query_batch(table, NULL, queries, results, count, threads);
+}
+
+void range_tree_query_batch(const range_tree* tree, const range_query* queries, range_result* results,
+                            long count, int threads) {
+    query_batch(NULL, tree, queries, results, count, threads);
+}
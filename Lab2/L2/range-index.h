@@ -0,0 +1,61 @@
+#ifndef LAB2_RANGE_INDEX_H
+#define LAB2_RANGE_INDEX_H
+
+// Индексы для запросов min/max на отрезке [left, right) массива из L2.c.
+//
+// range_table - для неизменяемых данных: массив делится на блоки по RANGE_BLOCK
+// элементов, внутри блока хранятся префиксные и суффиксные min/max, над блоками -
+// разреженная таблица. Запрос через границу блока отвечает за O(1), запрос внутри
+// одного блока - просмотром не более RANGE_BLOCK элементов.
+//
+// range_tree - дерево отрезков над теми же блоками, поддерживает замену элемента:
+// O(RANGE_BLOCK + log n) на обновление и O(log n) на запрос.
+
+#define RANGE_BLOCK 64
+
+typedef struct range_query {
+    long left;
+    long right;
+} range_query;
+
+typedef struct range_result {
+    int min;
+    int max;
+} range_result;
+
+typedef struct range_table {
+    const int* numbers;
+    long length;
+    long block_count;
+    int levels;
+    int* prefix_min;
+    int* prefix_max;
+    int* suffix_min;
+    int* suffix_max;
+    int** level_min;  // level_min[k][b] - минимум блоков [b, b + 2^k)
+    int** level_max;
+} range_table;
+
+typedef struct range_tree {
+    int* numbers;  // Обновления пишутся прямо в массив
+    long length;
+    long block_count;
+    long leaves;   // Число листьев, степень двойки
+    int* tree_min;
+    int* tree_max;
+} range_tree;
+
+int range_table_build(range_table* table, const int* numbers, long length, int threads);
+range_result range_table_query(const range_table* table, long left, long right);
+void range_table_query_batch(const range_table* table, const range_query* queries, range_result* results,
+                             long count, int threads);
+void range_table_destroy(range_table* table);
+
+int range_tree_build(range_tree* tree, int* numbers, long length, int threads);
+void range_tree_update(range_tree* tree, long index, int value);
+range_result range_tree_query(const range_tree* tree, long left, long right);
+void range_tree_query_batch(const range_tree* tree, const range_query* queries, range_result* results,
+                            long count, int threads);
+void range_tree_destroy(range_tree* tree);
+
+#endif
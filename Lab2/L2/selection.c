@@ -0,0 +1,467 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+
+#include "selection.h"
+#include "parallel.h"
+
+typedef struct sample_task {
+    const int* numbers;
+    long range_start;
+    long range_end;
+    int local_min;
+    int local_max;
+    int* samples;
+    long sample_count;
+} sample_task;
+
+typedef struct histogram_task {
+    const int* numbers;
+    long range_start;
+    long range_end;
+    int base;
+    long* counts;
+} histogram_task;
+
+typedef struct bracket_task {
+    const int* numbers;
+    long range_start;
+    long range_end;
+    int count;
+    const int* lower;
+    const int* upper;
+    long* below;          // below[j] - элементов меньше lower[j]
+    int** candidates;     // candidates[j] - элементы из [lower[j], upper[j]]
+    long* candidate_count;
+    long capacity;
+    int overflow;
+} bracket_task;
+
+typedef struct heap_task {
+    const int* numbers;
+    long range_start;
+    long range_end;
+    int* heap;  // Минимальная куча из k наибольших значений части
+    int k;
+    int size;
+} heap_task;
+
+static void swap_int(int* a, int* b) {
+    int t = *a;
+    *a = *b;
+    *b = t;
+}
+
+// Быстрый выбор: значение, которое стояло бы на позиции k после сортировки
+static int quickselect(int* numbers, long length, long k) {
+    long lo = 0, hi = length - 1;
+    while (lo < hi) {
+        long mid = lo + (hi - lo) / 2;
+        if (numbers[mid] < numbers[lo])
+            swap_int(&numbers[mid], &numbers[lo]);
+        if (numbers[hi] < numbers[lo])
+            swap_int(&numbers[hi], &numbers[lo]);
+        if (numbers[hi] < numbers[mid])
+            swap_int(&numbers[hi], &numbers[mid]);
+        int pivot = numbers[mid];
+
+        long i = lo, j = hi;
+        while (i <= j) {
+            while (numbers[i] < pivot)
+                i++;
+            while (numbers[j] > pivot)
+                j--;
+            if (i <= j) {
+                swap_int(&numbers[i], &numbers[j]);
+                i++;
+                j--;
+            }
+        }
+        if (k <= j)
+            hi = j;
+        else if (k >= i)
+            lo = i;
+        else
+            break;
+    }
+    return numbers[k];
+}
+
+static int compare_int(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_int_desc(const void* a, const void* b) {
+    return compare_int(b, a);
+}
+
+static long quantile_rank(double quantile, long length) {
+    long rank = (long)ceil(quantile * length);
+    if (rank < 1)
+        rank = 1;
+    if (rank > length)
+        rank = length;
+    return rank;
+}
+
+static void* scan_samples(void* arg) {
+    sample_task* task = (sample_task*)arg;
+    const int* numbers = task->numbers;
+
+    // split_range может дать пустую часть в конце - она не меняет общие min/max
+    int local_min = INT_MAX;
+    int local_max = INT_MIN;
+    for (long i = task->range_start; i < task->range_end; i++) {
+        if (numbers[i] < local_min)
+            local_min = numbers[i];
+        if (numbers[i] > local_max)
+            local_max = numbers[i];
+    }
+    task->local_min = local_min;
+    task->local_max = local_max;
+
+    long length = task->range_end - task->range_start;
+    long stride = length / SELECT_SAMPLES_PER_THREAD > 0 ? length / SELECT_SAMPLES_PER_THREAD : 1;
+    task->sample_count = 0;
+    for (long i = task->range_start; i < task->range_end && task->sample_count < SELECT_SAMPLES_PER_THREAD; i += stride) {
+        task->samples[task->sample_count++] = numbers[i];
+    }
+    return NULL;
+}
+
+static void* build_histogram(void* arg) {
+    histogram_task* task = (histogram_task*)arg;
+    for (long i = task->range_start; i < task->range_end; i++) {
+        task->counts[task->numbers[i] - task->base]++;
+    }
+    return NULL;
+}
+
+static void* collect_brackets(void* arg) {
+    bracket_task* task = (bracket_task*)arg;
+    for (long i = task->range_start; i < task->range_end; i++) {
+        int value = task->numbers[i];
+        for (int j = 0; j < task->count; j++) {
+            if (value < task->lower[j]) {
+                task->below[j]++;
+            } else if (value <= task->upper[j]) {
+                if (task->candidate_count[j] == task->capacity) {
+                    task->overflow = 1;
+                    return NULL;
+                }
+                task->candidates[j][task->candidate_count[j]++] = value;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void heap_sift_down(int* heap, int size, int index) {
+    while (1) {
+        int smallest = index, left = 2 * index + 1, right = 2 * index + 2;
+        if (left < size && heap[left] < heap[smallest])
+            smallest = left;
+        if (right < size && heap[right] < heap[smallest])
+            smallest = right;
+        if (smallest == index)
+            return;
+        swap_int(&heap[index], &heap[smallest]);
+        index = smallest;
+    }
+}
+
+static void* collect_top(void* arg) {
+    heap_task* task = (heap_task*)arg;
+    task->size = 0;
+    for (long i = task->range_start; i < task->range_end; i++) {
+        int value = task->numbers[i];
+        if (task->size < task->k) {
+            int index = task->size++;
+            task->heap[index] = value;
+            while (index > 0 && task->heap[(index - 1) / 2] > task->heap[index]) {
+                swap_int(&task->heap[(index - 1) / 2], &task->heap[index]);
+                index = (index - 1) / 2;
+            }
+        } else if (value > task->heap[0]) {
+            task->heap[0] = value;
+            heap_sift_down(task->heap, task->size, 0);
+        }
+    }
+    return NULL;
+}
+
+// Первый проход: min/max и отсортированная выборка. Возвращает число потоков или -1
+static int sample_pass(const int* numbers, long length, int threads, int* global_min, int* global_max,
+                       int** sorted_samples, long* sample_count) {
+    threads = clamp_threads(threads, length);
+    sample_task* tasks = malloc(threads * sizeof(sample_task));
+    int* samples = malloc((size_t)threads * SELECT_SAMPLES_PER_THREAD * sizeof(int));
+    if (!tasks || !samples) {
+        free(tasks);
+        free(samples);
+        return -1;
+    }
+    for (int i = 0; i < threads; i++) {
+        tasks[i].numbers = numbers;
+        tasks[i].samples = samples + (size_t)i * SELECT_SAMPLES_PER_THREAD;
+        split_range(length, threads, i, &tasks[i].range_start, &tasks[i].range_end);
+    }
+    if (run_threads(scan_samples, tasks, sizeof(sample_task), threads) != 0) {
+        free(tasks);
+        free(samples);
+        return -1;
+    }
+
+    *global_min = INT_MAX;
+    *global_max = INT_MIN;
+    long total = 0;
+    for (int i = 0; i < threads; i++) {
+        if (tasks[i].range_start == tasks[i].range_end)
+            continue;
+        if (tasks[i].local_min < *global_min)
+            *global_min = tasks[i].local_min;
+        if (tasks[i].local_max > *global_max)
+            *global_max = tasks[i].local_max;
+        memmove(samples + total, tasks[i].samples, tasks[i].sample_count * sizeof(int));
+        total += tasks[i].sample_count;
+    }
+    qsort(samples, total, sizeof(int), compare_int);
+
+    free(tasks);
+    *sorted_samples = samples;
+    *sample_count = total;
+    return threads;
+}
+
+// Второй проход для малого диапазона значений: сумма гистограмм всех потоков
+static long* histogram_pass(const int* numbers, long length, int threads, int base, long buckets) {
+    histogram_task* tasks = malloc(threads * sizeof(histogram_task));
+    long* counts = calloc((size_t)threads * buckets, sizeof(long));
+    if (!tasks || !counts) {
+        free(tasks);
+        free(counts);
+        return NULL;
+    }
+    for (int i = 0; i < threads; i++) {
+        tasks[i].numbers = numbers;
+        tasks[i].base = base;
+        tasks[i].counts = counts + (size_t)i * buckets;
+        split_range(length, threads, i, &tasks[i].range_start, &tasks[i].range_end);
+    }
+    if (run_threads(build_histogram, tasks, sizeof(histogram_task), threads) != 0) {
+        free(tasks);
+        free(counts);
+        return NULL;
+    }
+    for (int i = 1; i < threads; i++) {
+        for (long b = 0; b < buckets; b++)
+            counts[b] += counts[(size_t)i * buckets + b];
+    }
+    free(tasks);
+    return counts;
+}
+
+// Запасной путь: выбор по копии всего массива
+static int select_by_copy(const int* numbers, long length, const double* quantiles, int* results, int count) {
+    int* copy = malloc(length * sizeof(int));
+    if (!copy)
+        return -1;
+    memcpy(copy, numbers, length * sizeof(int));
+    for (int j = 0; j < count; j++) {
+        results[j] = quickselect(copy, length, quantile_rank(quantiles[j], length) - 1);
+    }
+    free(copy);
+    return 0;
+}
+
+static int select_by_brackets(const int* numbers, long length, const double* quantiles, int* results, int count,
+                              int threads, int global_min, int global_max, const int* samples, long sample_count) {
+    int* lower = malloc(count * sizeof(int));
+    int* upper = malloc(count * sizeof(int));
+    bracket_task* tasks = calloc(threads, sizeof(bracket_task));
+    if (!lower || !upper || !tasks) {
+        free(lower);
+        free(upper);
+        free(tasks);
+        return -1;
+    }
+
+    // Интервал вокруг ожидаемой позиции в выборке: несколько стандартных отклонений ранга
+    long margin = (long)(4 * sqrt((double)sample_count)) + 1;
+    for (int j = 0; j < count; j++) {
+        long position = (long)(quantiles[j] * (sample_count - 1));
+        lower[j] = position - margin <= 0 ? global_min : samples[position - margin];
+        upper[j] = position + margin >= sample_count - 1 ? global_max : samples[position + margin];
+    }
+
+    long chunk = length / threads + 1;
+    long capacity = (long)((double)chunk * (2 * margin + 1) / sample_count * 2) + 1024;
+    int failed = 0;
+    for (int i = 0; i < threads && !failed; i++) {
+        tasks[i].numbers = numbers;
+        tasks[i].count = count;
+        tasks[i].lower = lower;
+        tasks[i].upper = upper;
+        tasks[i].capacity = capacity;
+        tasks[i].below = calloc(count, sizeof(long));
+        tasks[i].candidate_count = calloc(count, sizeof(long));
+        tasks[i].candidates = calloc(count, sizeof(int*));
+        failed = !tasks[i].below || !tasks[i].candidate_count || !tasks[i].candidates;
+        for (int j = 0; j < count && !failed; j++) {
+            tasks[i].candidates[j] = malloc(capacity * sizeof(int));
+            failed = !tasks[i].candidates[j];
+        }
+        split_range(length, threads, i, &tasks[i].range_start, &tasks[i].range_end);
+    }
+    if (!failed)
+        failed = run_threads(collect_brackets, tasks, sizeof(bracket_task), threads) != 0;
+    for (int i = 0; i < threads && !failed; i++)
+        failed = tasks[i].overflow;
+
+    int missed = failed;
+    for (int j = 0; j < count && !missed; j++) {
+        long below = 0, total = 0;
+        for (int i = 0; i < threads; i++) {
+            below += tasks[i].below[j];
+            total += tasks[i].candidate_count[j];
+        }
+        long rank = quantile_rank(quantiles[j], length);
+        if (rank <= below || rank > below + total) {
+            missed = 1;
+            break;
+        }
+
+        // Собираем кандидатов всех потоков в буфер первого и выбираем среди них
+        int* merged = malloc(total * sizeof(int));
+        if (!merged) {
+            missed = 1;
+            break;
+        }
+        long offset = 0;
+        for (int i = 0; i < threads; i++) {
+            memcpy(merged + offset, tasks[i].candidates[j], tasks[i].candidate_count[j] * sizeof(int));
+            offset += tasks[i].candidate_count[j];
+        }
+        results[j] = quickselect(merged, total, rank - below - 1);
+        free(merged);
+    }
+
+    for (int i = 0; i < threads; i++) {
+        if (tasks[i].candidates) {
+            for (int j = 0; j < count; j++)
+                free(tasks[i].candidates[j]);
+        }
+        free(tasks[i].candidates);
+        free(tasks[i].candidate_count);
+        free(tasks[i].below);
+    }
+    free(tasks);
+    free(lower);
+    free(upper);
+
+    return missed ? select_by_copy(numbers, length, quantiles, results, count) : 0;
+}
+
+int select_quantiles(const int* numbers, long length, const double* quantiles, int* results, int count,
+                     int threads) {
+    if (length <= 0 || count <= 0)
+        return -1;
+    for (int j = 0; j < count; j++) {
+        if (quantiles[j] < 0 || quantiles[j] > 1)
+            return -1;
+    }
+
+    int global_min, global_max;
+    int* samples;
+    long sample_count;
+    threads = sample_pass(numbers, length, threads, &global_min, &global_max, &samples, &sample_count);
+    if (threads < 0)
+        return -1;
+
+    int status = 0;
+    long buckets = (long)global_max - global_min + 1;
+    if (buckets <= SELECT_COUNTING_LIMIT) {
+        long* counts = histogram_pass(numbers, length, threads, global_min, buckets);
+        if (!counts) {
+            status = select_by_copy(numbers, length, quantiles, results, count);
+        } else {
+            for (int j = 0; j < count; j++) {
+                long rank = quantile_rank(quantiles[j], length);
+                long seen = 0, b = 0;
+                while (seen + counts[b] < rank) {
+                    seen += counts[b];
+                    b++;
+                }
+                results[j] = (int)(global_min + b);
+            }
+            free(counts);
+        }
+    } else {
+        status = select_by_brackets(numbers, length, quantiles, results, count, threads, global_min, global_max,
+                                    samples, sample_count);
+    }
+
+    free(samples);
+    return status;
+}
+
+int select_top_k(const int* numbers, long length, int* results, int k, int threads) {
+    if (length <= 0 || k <= 0 || k > length)
+        return -1;
+
+    int global_min, global_max;
+    int* samples;
+    long sample_count;
+    threads = sample_pass(numbers, length, threads, &global_min, &global_max, &samples, &sample_count);
+    if (threads < 0)
+        return -1;
+    free(samples);
+
+    long buckets = (long)global_max - global_min + 1;
+    if (buckets <= SELECT_COUNTING_LIMIT) {
+        long* counts = histogram_pass(numbers, length, threads, global_min, buckets);
+        if (counts) {
+            int filled = 0;
+            for (long b = buckets - 1; b >= 0 && filled < k; b--) {
+                for (long c = 0; c < counts[b] && filled < k; c++)
+                    results[filled++] = (int)(global_min + b);
+            }
+            free(counts);
+            return 0;
+        }
+    }
+
+    // Каждый поток держит кучу своих k наибольших, затем кучи сливаются
+    heap_task* tasks = malloc(threads * sizeof(heap_task));
+    int* heaps = malloc((size_t)threads * k * sizeof(int));
+    if (!tasks || !heaps) {
+        free(tasks);
+        free(heaps);
+        return -1;
+    }
+    for (int i = 0; i < threads; i++) {
+        tasks[i].numbers = numbers;
+        tasks[i].heap = heaps + (size_t)i * k;
+        tasks[i].k = k;
+        split_range(length, threads, i, &tasks[i].range_start, &tasks[i].range_end);
+    }
+    if (run_threads(collect_top, tasks, sizeof(heap_task), threads) != 0) {
+        free(tasks);
+        free(heaps);
+        return -1;
+    }
+
+    long total = 0;
+    for (int i = 0; i < threads; i++) {
+        memmove(heaps + total, tasks[i].heap, tasks[i].size * sizeof(int));
+        total += tasks[i].size;
+    }
+    qsort(heaps, total, sizeof(int), compare_int_desc);
+    memcpy(results, heaps, k * sizeof(int));
+
+    free(tasks);
+    free(heaps);
+    return 0;
+}
@@ -0,0 +1,23 @@
+#ifndef LAB2_SELECTION_H
+#define LAB2_SELECTION_H
+
+// Параллельный выбор квантилей и k наибольших значений без полной сортировки.
+//
+// Первый проход в каждом потоке находит локальные min/max и берёт равномерную выборку.
+// Если диапазон значений не больше SELECT_COUNTING_LIMIT (как у rand() % 1000 в L2.c),
+// второй проход строит гистограммы по потокам и ответ читается из их суммы.
+// Иначе по выборке для каждого квантиля выбирается узкий интервал значений, второй проход
+// считает элементы левее интервала и собирает попавшие в него, а нужный ранг ищется
+// быстрым выбором среди собранных. Если интервал промахнулся, выбор делается по копии массива.
+
+#define SELECT_COUNTING_LIMIT (1 << 16)
+#define SELECT_SAMPLES_PER_THREAD 4096
+
+// Квантиль q из [0, 1] - элемент с рангом ceil(q * length) (нумерация с 1) в отсортированном массиве
+int select_quantiles(const int* numbers, long length, const double* quantiles, int* results, int count,
+                     int threads);
+
+// k наибольших значений в порядке убывания
+int select_top_k(const int* numbers, long length, int* results, int k, int threads);
+
+#endif
@@ -1,125 +1,188 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <unistd.h>
-#include <sys/mman.h>
-#include <fcntl.h>
-#include <semaphore.h>
-#include <sys/types.h>
-#include <sys/wait.h>
-
-#define SHM_NAME "/my_shared_memory"
-#define SEM_WRITE "/sem_write"
-#define SEM_READ "/sem_read"
-#define BUFFER_SIZE 100
-
-int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        fprintf(stderr, "Необходимо указать имя файла в качестве аргумента.\n");
-        exit(EXIT_FAILURE);
-    }
-
-    // Удаляем старые ресурсы, если они существуют
-    shm_unlink(SHM_NAME);
-    sem_unlink(SEM_WRITE);
-    sem_unlink(SEM_READ);
-
-    // Создаем и настраиваем общую память
-    int shm_fd = shm_open(SHM_NAME, O_CREAT | O_RDWR, 0644);
-    if (shm_fd == -1) {
-        perror("shm_open");
-        exit(EXIT_FAILURE);
-    }
-    if (ftruncate(shm_fd, BUFFER_SIZE) == -1) {
-        perror("ftruncate");
-        shm_unlink(SHM_NAME);
-        exit(EXIT_FAILURE);
-    }
-    char *shared_memory = mmap(NULL, BUFFER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
-    if (shared_memory == MAP_FAILED) {
-        perror("mmap");
-        shm_unlink(SHM_NAME);
-        exit(EXIT_FAILURE);
-    }
-
-    // Создаем семафоры
-    sem_t *sem_write = sem_open(SEM_WRITE, O_CREAT | O_EXCL, 0644, 1);
-    sem_t *sem_read = sem_open(SEM_READ, O_CREAT | O_EXCL, 0644, 0);
-    if (sem_write == SEM_FAILED || sem_read == SEM_FAILED) {
-        perror("sem_open");
-        shm_unlink(SHM_NAME);
-        sem_unlink(SEM_WRITE);
-        sem_unlink(SEM_READ);
-        exit(EXIT_FAILURE);
-    }
-
-    pid_t pid = fork();
-    if (pid == -1) {
-        perror("fork");
-        munmap(shared_memory, BUFFER_SIZE);
-        shm_unlink(SHM_NAME);
-        sem_unlink(SEM_WRITE);
-        sem_unlink(SEM_READ);
-        exit(EXIT_FAILURE);
-    } else if (pid == 0) { // Дочерний процесс
-        char buffer[BUFFER_SIZE];
-        while (1) {
-            // Ожидание разрешения на чтение от родителя
-            sem_wait(sem_read);
-
-            // Проверяем, есть ли "end"
-            if (strcmp(shared_memory, "end") == 0) {
-                break;
-            }
-
-            // Чтение из общей памяти
-            strncpy(buffer, shared_memory, BUFFER_SIZE);
-            buffer[BUFFER_SIZE - 1] = '\0';
-
-            // Вывод для проверки
-            printf("[Child] Прочитано из общей памяти: %s\n", buffer);
-
-            // Разрешаем родителю записывать
-            sem_post(sem_write);
-        }
-
-        // Завершаем работу
-        munmap(shared_memory, BUFFER_SIZE);
-        sem_close(sem_write);
-        sem_close(sem_read);
-        exit(EXIT_SUCCESS);
-    } else { // Родительский процесс
-        char input[BUFFER_SIZE];
-        while (1) {
-            printf("Введите числа (или end для завершения): ");
-            fgets(input, BUFFER_SIZE, stdin);
-            input[strcspn(input, "\n")] = '\0'; // Убираем символ новой строки
-
-            // Ожидание разрешения на запись
-            sem_wait(sem_write);
-
-            // Пишем в общую память
-            strncpy(shared_memory, input, BUFFER_SIZE);
-
-            // Разрешаем дочернему процессу читать
-            sem_post(sem_read);
-
-            if (strcmp(input, "end") == 0) {
-                break;
-            }
-        }
-
-        // Ожидаем завершения дочернего процесса
-        wait(NULL);
-
-        // Освобождаем ресурсы
-        munmap(shared_memory, BUFFER_SIZE);
-        shm_unlink(SHM_NAME);
-        sem_close(sem_write);
-        sem_close(sem_read);
-        sem_unlink(SEM_WRITE);
-        sem_unlink(SEM_READ);
-    }
-
-    return 0;
-}
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <semaphore.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "../../Lab1/L1/frame.h"
+#include "../../Trace/trace.h"
+
+#define SHM_NAME "/my_shared_memory"
+#define SEM_WRITE "/sem_write"
+#define SEM_READ "/sem_read"
+#define BUFFER_SIZE 100
+// В строке из BUFFER_SIZE символов не больше BUFFER_SIZE / 2 чисел
+#define FRAME_CAPACITY (BUFFER_SIZE / 2)
+#define SHM_SIZE (sizeof(frame_header) + FRAME_CAPACITY * sizeof(float) > BUFFER_SIZE ? \
+                  sizeof(frame_header) + FRAME_CAPACITY * sizeof(float) : BUFFER_SIZE)
+
+// Двоичный режим: родитель разбирает строку прямо в кадр в общей памяти
+void write_frame(char *shared_memory, char *input) {
+    frame_header header;
+    float *values = (float *)(shared_memory + sizeof(frame_header));
+    uint32_t count = 0;
+    char *endptr;
+
+    if (strcmp(input, "end") == 0) {
+        frame_header_init(&header, FRAME_END, 0);
+    } else {
+        for (char *token = strtok(input, " "); token != NULL && count < FRAME_CAPACITY; token = strtok(NULL, " ")) {
+            errno = 0;
+            float value = strtof(token, &endptr);
+            if (errno == 0 && *endptr == '\0') {
+                values[count++] = value;
+            } else {
+                fprintf(stderr, "Invalid number in input. Skipping.\n"); // "Недопустимое число во входных данных. Пропуск."
+            }
+        }
+        frame_header_init(&header, FRAME_FLOAT32, count);
+    }
+    memcpy(shared_memory, &header, sizeof(header));
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Необходимо указать имя файла в качестве аргумента.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // ./parent <файл> --binary: числа передаются через общую память кадрами frame.h, а не строкой
+    int binary = argc > 2 && strcmp(argv[2], "--binary") == 0;
+
+    // Удаляем старые ресурсы, если они существуют
+    shm_unlink(SHM_NAME);
+    sem_unlink(SEM_WRITE);
+    sem_unlink(SEM_READ);
+
+    // Создаем и настраиваем общую память
+    int shm_fd = shm_open(SHM_NAME, O_CREAT | O_RDWR, 0644);
+    if (shm_fd == -1) {
+        perror("shm_open");
+        exit(EXIT_FAILURE);
+    }
+    if (ftruncate(shm_fd, SHM_SIZE) == -1) {
+        perror("ftruncate");
+        shm_unlink(SHM_NAME);
+        exit(EXIT_FAILURE);
+    }
+    char *shared_memory = mmap(NULL, SHM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    if (shared_memory == MAP_FAILED) {
+        perror("mmap");
+        shm_unlink(SHM_NAME);
+        exit(EXIT_FAILURE);
+    }
+
+    // Создаем семафоры
+    sem_t *sem_write = sem_open(SEM_WRITE, O_CREAT | O_EXCL, 0644, 1);
+    sem_t *sem_read = sem_open(SEM_READ, O_CREAT | O_EXCL, 0644, 0);
+    if (sem_write == SEM_FAILED || sem_read == SEM_FAILED) {
+        perror("sem_open");
+        shm_unlink(SHM_NAME);
+        sem_unlink(SEM_WRITE);
+        sem_unlink(SEM_READ);
+        exit(EXIT_FAILURE);
+    }
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork");
+        munmap(shared_memory, SHM_SIZE);
+        shm_unlink(SHM_NAME);
+        sem_unlink(SEM_WRITE);
+        sem_unlink(SEM_READ);
+        exit(EXIT_FAILURE);
+    } else if (pid == 0) { // Дочерний процесс
+        char buffer[BUFFER_SIZE];
+        while (1) {
+            // Ожидание разрешения на чтение от родителя
+            TRACE_BEGIN("child wait sem_read");
+            sem_wait(sem_read);
+            TRACE_END("child wait sem_read");
+
+            if (binary) {
+                // Суммируем прямо из общей памяти, без копии и разбора текста
+                frame_header header;
+                memcpy(&header, shared_memory, sizeof(header));
+                if (frame_payload_size(&header) < 0 || header.type == FRAME_END) {
+                    break;
+                }
+                printf("[Child] Сумма кадра из %u чисел: %.2f\n", header.count,
+                       frame_sum(&header, shared_memory + sizeof(frame_header)));
+                TRACE_INSTANT("child post sem_write", header.count);
+                sem_post(sem_write);
+                continue;
+            }
+
+            // Проверяем, есть ли "end"
+            if (strcmp(shared_memory, "end") == 0) {
+                break;
+            }
+
+            // Чтение из общей памяти
+            strncpy(buffer, shared_memory, BUFFER_SIZE);
+            buffer[BUFFER_SIZE - 1] = '\0';
+
+            // Вывод для проверки
+            printf("[Child] Прочитано из общей памяти: %s\n", buffer);
+
+            // Разрешаем родителю записывать
+            TRACE_INSTANT("child post sem_write", 0);
+            sem_post(sem_write);
+        }
+
+        // Завершаем работу
+        munmap(shared_memory, SHM_SIZE);
+        sem_close(sem_write);
+        sem_close(sem_read);
+        exit(EXIT_SUCCESS);
+    } else { // Родительский процесс
+        char input[BUFFER_SIZE];
+        while (1) {
+            printf("Введите числа (или end для завершения): ");
+            fgets(input, BUFFER_SIZE, stdin);
+            input[strcspn(input, "\n")] = '\0'; // Убираем символ новой строки
+            int finished = strcmp(input, "end") == 0; // write_frame портит строку при разборе
+            if (binary && input[0] == '\0') {
+                continue; // Пустая строка не превращается в пустой кадр
+            }
+
+            // Ожидание разрешения на запись
+            TRACE_BEGIN("parent wait sem_write");
+            sem_wait(sem_write);
+            TRACE_END("parent wait sem_write");
+
+            // Пишем в общую память
+            if (binary) {
+                write_frame(shared_memory, input);
+            } else {
+                strncpy(shared_memory, input, BUFFER_SIZE);
+            }
+
+            // Разрешаем дочернему процессу читать
+            TRACE_INSTANT("parent post sem_read", 0);
+            sem_post(sem_read);
+
+            if (finished) {
+                break;
+            }
+        }
+
+        // Ожидаем завершения дочернего процесса
+        wait(NULL);
+
+        // Освобождаем ресурсы
+        munmap(shared_memory, SHM_SIZE);
+        shm_unlink(SHM_NAME);
+        sem_close(sem_write);
+        sem_close(sem_read);
+        sem_unlink(SEM_WRITE);
+        sem_unlink(SEM_READ);
+    }
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include "allocator-fast.h"
+
+__thread FastCache fast_cache;
+
+// Ключ нужен только ради деструктора: значение - кэш потока, пока он привязан к бэкенду
+static pthread_key_t fast_key;
+static pthread_once_t fast_key_once = PTHREAD_ONCE_INIT;
+
+// Деструктор ключа: поток завершился, не вызвав fast_flush
+static void fast_thread_exit(void *cache) {
+    (void) cache;
+    fast_flush();
+}
+
+static void fast_key_create(void) {
+    pthread_key_create(&fast_key, fast_thread_exit);
+}
+
+void fast_flush(void) {
+    FastCache *cache = &fast_cache;
+    FastBackend *backend = cache->backend;
+    if (backend == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&backend->lock);
+    for (size_t index = 0; index < FAST_CLASSES; index++) {
+        while (cache->heads[index] != NULL) {
+            void *block = cache->heads[index];
+            cache->heads[index] = *(void **) block;
+            backend->free(backend->allocator, block);
+        }
+        cache->counts[index] = 0;
+    }
+    pthread_mutex_unlock(&backend->lock);
+    cache->backend = NULL;
+}
+
+void fast_backend_destroy(FastBackend *backend) {
+    if (fast_cache.backend == backend) {
+        fast_flush();
+    }
+    pthread_mutex_destroy(&backend->lock);
+}
+
+// Кэш потока привязывается к одному бэкенду: при смене блоки старого возвращаются ему.
+// При первой привязке в потоке регистрируется деструктор, сбрасывающий кэш при завершении потока
+static void fast_bind(FastCache *cache, FastBackend *backend) {
+    if (cache->backend != backend) {
+        fast_flush();
+        cache->backend = backend;
+        pthread_once(&fast_key_once, fast_key_create);
+        if (pthread_getspecific(fast_key) == NULL) {
+            pthread_setspecific(fast_key, cache);
+        }
+    }
+}
+
+void *fast_refill(FastBackend *backend, size_t index) {
+    FastCache *cache = &fast_cache;
+    fast_bind(cache, backend);
+
+    void *batch[FAST_BATCH];
+    size_t count = 0;
+    pthread_mutex_lock(&backend->lock);
+    while (count < FAST_BATCH) {
+        void *block = backend->alloc(backend->allocator, fast_class_size(index));
+        if (block == NULL) {
+            break;
+        }
+        batch[count++] = block;
+    }
+    pthread_mutex_unlock(&backend->lock);
+
+    if (count == 0) {
+        return NULL;
+    }
+    // Первый блок отдаётся сразу, остальные - в список в порядке адресов
+    for (size_t i = count - 1; i > 0; i--) {
+        *(void **) batch[i] = cache->heads[index];
+        cache->heads[index] = batch[i];
+    }
+    cache->counts[index] += count - 1;
+    return batch[0];
+}
+
+void fast_overflow(FastBackend *backend, size_t index) {
+    FastCache *cache = &fast_cache;
+    pthread_mutex_lock(&backend->lock);
+    for (size_t i = 0; i < FAST_LIST_LIMIT / 2; i++) {
+        void *block = cache->heads[index];
+        cache->heads[index] = *(void **) block;
+        backend->free(backend->allocator, block);
+    }
+    pthread_mutex_unlock(&backend->lock);
+    cache->counts[index] -= FAST_LIST_LIMIT / 2;
+}
+
+void *fast_alloc_large(FastBackend *backend, size_t size) {
+    pthread_mutex_lock(&backend->lock);
+    void *block = backend->alloc(backend->allocator, size);
+    pthread_mutex_unlock(&backend->lock);
+    return block;
+}
+
+void fast_free_slow(FastBackend *backend, void *memory, size_t size) {
+    if (size > FAST_MAX_SIZE) {
+        pthread_mutex_lock(&backend->lock);
+        backend->free(backend->allocator, memory);
+        pthread_mutex_unlock(&backend->lock);
+        return;
+    }
+    FastCache *cache = &fast_cache;
+    fast_bind(cache, backend);
+    size_t index = fast_class(size);
+    *(void **) memory = cache->heads[index];
+    cache->heads[index] = memory;
+    cache->counts[index]++;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+// Необязательный встраиваемый фронтенд над любым из аллокаторов Lab4.
+//
+// Бэкенд по-прежнему выбирается во время работы (dlopen + dlsym в main.c): FastBackend хранит
+// его указатели на allocator_alloc/allocator_free. Мелкие запросы (до FAST_MAX_SIZE) округляются
+// до класса-степени двойки по таблице: при константном размере индекс и размер класса
+// вычисляются компилятором, и fast_alloc/fast_free сводятся к снятию/вставке в голову
+// списка свободных блоков текущего потока. В .so управление уходит только при пустом
+// списке (пачка из FAST_BATCH блоков) и при переполнении (половина списка возвращается).
+//
+// Ограничения:
+// - размер передаётся и в fast_free (заголовка с классом у блока нет), и он должен совпадать
+//   с размером при выделении;
+// - блоки, выделенные через fast_alloc, освобождаются только через fast_free;
+// - кэш потока сбрасывается в бэкенд сам при завершении потока (деструктор pthread_key_create);
+//   кэш главного потока сбрасывает fast_flush или fast_backend_destroy перед allocator_destroy.
+//
+// Сборка вместе с allocator-fast.c: gcc -O2 -o main main.c allocator-fast.c -ldl -pthread
+
+#define FAST_GRANULE 16
+#define FAST_MAX_SIZE 1024
+#define FAST_CLASSES 7  // 16, 32, ..., 1024
+#define FAST_BATCH 32
+#define FAST_LIST_LIMIT (2 * FAST_BATCH)
+
+struct Allocator;
+
+typedef void *fast_alloc_func(struct Allocator *const allocator, const size_t size);
+
+typedef void fast_free_func(struct Allocator *const allocator, void *const memory);
+
+typedef struct FastBackend {
+    struct Allocator *allocator;
+    fast_alloc_func *alloc;
+    fast_free_func *free;
+    pthread_mutex_t lock;  // Аллокаторы Lab4 не потокобезопасны - медленный путь под блокировкой
+} FastBackend;
+
+typedef struct FastCache {
+    void *heads[FAST_CLASSES];  // Следующий свободный блок хранится в первых байтах блока
+    uint32_t counts[FAST_CLASSES];
+    FastBackend *backend;
+} FastCache;
+
+// Кэш текущего потока; определён один раз в allocator-fast.c, общий для всех единиц трансляции
+extern __thread FastCache fast_cache;
+
+// Класс по числу гранул (size + 15) / 16; нулевой размер попадает в класс 16 байт
+static const uint8_t fast_class_table[FAST_MAX_SIZE / FAST_GRANULE + 1] = {
+        [0 ... 1] = 0, [2] = 1, [3 ... 4] = 2, [5 ... 8] = 3,
+        [9 ... 16] = 4, [17 ... 32] = 5, [33 ... 64] = 6,
+};
+
+static inline size_t fast_class(size_t size) {
+    return fast_class_table[(size + FAST_GRANULE - 1) / FAST_GRANULE];
+}
+
+static inline size_t fast_class_size(size_t index) {
+    return (size_t) FAST_GRANULE << index;
+}
+
+static inline int fast_backend_init(FastBackend *backend, struct Allocator *allocator, fast_alloc_func *alloc,
+                                    fast_free_func *free) {
+    backend->allocator = allocator;
+    backend->alloc = alloc;
+    backend->free = free;
+    return pthread_mutex_init(&backend->lock, NULL);
+}
+
+// Парная fast_backend_init: сбрасывает кэш текущего потока, если он привязан к backend,
+// и освобождает блокировку. Кэши других потоков к этому моменту должны быть сброшены
+void fast_backend_destroy(FastBackend *backend);
+
+// Возвращает все блоки из кэша текущего потока в бэкенд
+void fast_flush(void);
+
+// Медленные пути в allocator-fast.c, под блокировкой бэкенда
+void *fast_refill(FastBackend *backend, size_t index);
+
+void fast_overflow(FastBackend *backend, size_t index);
+
+void *fast_alloc_large(FastBackend *backend, size_t size);
+
+void fast_free_slow(FastBackend *backend, void *memory, size_t size);
+
+static inline void *fast_alloc(FastBackend *backend, size_t size) {
+    if (size > FAST_MAX_SIZE) {
+        return fast_alloc_large(backend, size);
+    }
+    size_t index = fast_class(size);
+    FastCache *cache = &fast_cache;
+    void *block = cache->heads[index];
+    if (__builtin_expect(block != NULL && cache->backend == backend, 1)) {
+        cache->heads[index] = *(void **) block;
+        cache->counts[index]--;
+        return block;
+    }
+    return fast_refill(backend, index);
+}
+
+static inline void fast_free(FastBackend *backend, void *memory, size_t size) {
+    if (memory == NULL) {
+        return;
+    }
+    FastCache *cache = &fast_cache;
+    if (__builtin_expect(size > FAST_MAX_SIZE || cache->backend != backend, 0)) {
+        fast_free_slow(backend, memory, size);
+        return;
+    }
+    size_t index = fast_class(size);
+    *(void **) memory = cache->heads[index];
+    cache->heads[index] = memory;
+    if (__builtin_expect(++cache->counts[index] > FAST_LIST_LIMIT, 0)) {
+        fast_overflow(backend, index);
+    }
+}
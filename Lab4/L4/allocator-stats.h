@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stddef.h>
+
+// Классы размеров для статистики: класс i содержит блоки, у которых полезный размер
+// (то, что вернёт allocator_usable_size, без заголовка) лежит в (2^(i-1), 2^i];
+// последний класс - всё, что больше 2^(ALLOCATOR_STATS_CLASSES - 2).
+//
+// largest_free_block - оценка снизу полезного размера наибольшего свободного блока:
+// запрос такого размера гарантированно найдёт блок без роста кучи. Если точный размер
+// неизвестен без обхода кучи, это нижняя граница его класса 2^(i-1) + 1, иначе сам размер.
+#define ALLOCATOR_STATS_CLASSES 13
+
+typedef struct AllocatorStats {
+    size_t total_bytes;
+    size_t region_count;
+    size_t used_bytes;
+    size_t free_bytes;
+    size_t largest_free_block;
+    size_t alloc_count;
+    size_t free_count;
+    size_t failed_allocs;
+    size_t class_used[ALLOCATOR_STATS_CLASSES];
+} AllocatorStats;
+
+// Показатель ближайшей степени двойки, не меньшей size, без ограничения сверху
+static inline size_t allocator_size_class(size_t size) {
+    if (size <= 1) {
+        return 0;
+    }
+    return (size_t) (64 - __builtin_clzll(size - 1));
+}
+
+static inline size_t allocator_stats_class(size_t size) {
+    size_t class = allocator_size_class(size);
+    return class < ALLOCATOR_STATS_CLASSES - 1 ? class : ALLOCATOR_STATS_CLASSES - 1;
+}
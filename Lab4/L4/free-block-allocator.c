@@ -1,72 +1,323 @@
-#include "free-block-allocator.h"
-
-
-Allocator *allocator_create(void *const memory, const size_t size) {
-    if (memory == NULL) {
-        return NULL;
-    }
-
-
-    Allocator* allocator = (Allocator*)memory;
-    allocator->memory = (void *) ((char *) memory + sizeof(Allocator));
-    allocator->size = size - sizeof(Allocator);
-    allocator->free_list = (Block*)allocator->memory;
-    allocator->free_list->size = allocator->size - sizeof(Block);
-    allocator->free_list->next = NULL;
-    allocator->free_list->is_free = 1;
-
-    return allocator;
-}
-
-void *allocator_alloc(Allocator *allocator, size_t size) {
-    if(allocator == NULL){
-        return NULL;
-    }
-    if(size > allocator->size){
-        return NULL;
-    }
-    Block *curr = allocator->free_list;
-    while (curr != NULL) {
-        if (curr->is_free && curr->size >= size) {
-            if (curr->size >= size + sizeof(Block) + 1) {
-                Block *new_block = (Block *) ((char *) curr + sizeof(Block) + size);
-                new_block->size = curr->size - size - sizeof(Block);
-                new_block->next = curr->next;
-                new_block->is_free = 1;
-
-                curr->size = size;
-                curr->next = new_block;
-            }
-
-            curr->is_free = 0;
-            return (void *) (curr + 1);
-        }
-        curr = curr->next;
-    }
-
-    return NULL;
-}
-
-void allocator_free(Allocator *allocator, void *ptr) {
-    if (ptr == NULL) return;
-
-    Block *block = (Block *) ptr - 1;
-    block->is_free = 1;
-
-
-    Block *curr = allocator->free_list;
-    while (curr != NULL && curr->next != NULL) {
-        if (curr->is_free && curr->next->is_free) {
-            curr->size += sizeof(Block) + curr->next->size;
-            curr->next = curr->next->next;
-        } else {
-            curr = curr->next;
-        }
-    }
-}
-
-void allocator_destroy(Allocator* allocator) {
-    if (munmap(allocator, allocator->size + sizeof(Allocator)) == -1) {
-        perror("munmap failed");
-    }
+#include "free-block-allocator.h"
+#include "../../Trace/trace.h"
+
+
+// Учёт свободных блоков по классам: вызывается при каждом появлении и исчезновении свободного блока
+static void free_block_add(Allocator *allocator, size_t size) {
+    allocator->free_blocks[allocator_size_class(size)]++;
+}
+
+static void free_block_remove(Allocator *allocator, size_t size) {
+    allocator->free_blocks[allocator_size_class(size)]--;
+}
+
+Allocator *allocator_create(void *const memory, const size_t size) {
+    if (memory == NULL) {
+        return NULL;
+    }
+
+
+    Allocator* allocator = (Allocator*)memory;
+    allocator->memory = (void *) ((char *) memory + sizeof(Allocator));
+    allocator->size = size - sizeof(Allocator);
+    allocator->free_list = (Block*)allocator->memory;
+    allocator->free_list->size = allocator->size - sizeof(Block);
+    allocator->free_list->next = NULL;
+    allocator->free_list->is_free = 1;
+
+    allocator->regions = NULL;
+    allocator->region_count = 0;
+    allocator->next_region_size = size;
+    allocator->region_bytes = 0;
+
+    allocator->used_bytes = 0;
+    allocator->free_bytes = allocator->free_list->size;
+    memset(allocator->free_blocks, 0, sizeof(allocator->free_blocks));
+    free_block_add(allocator, allocator->free_list->size);
+    allocator->alloc_count = 0;
+    allocator->free_count = 0;
+    allocator->failed_allocs = 0;
+    memset(allocator->class_used, 0, sizeof(allocator->class_used));
+
+    return allocator;
+}
+
+// Отображает новую область, вдвое больше предыдущей (до REGION_GROW_LIMIT), и ставит её блок
+// в начало списка; если столько не отображается - область меньше, но вмещающая size
+static Block *allocator_grow(Allocator *allocator, size_t size) {
+    size_t region_size = allocator->next_region_size;
+    Region *region = (Region *) region_map_fallback(&region_size, sizeof(Region) + sizeof(Block) + size);
+    if (region == NULL) {
+        return NULL;
+    }
+    region->size = region_size;
+    region->next = allocator->regions;
+    allocator->regions = region;
+    allocator->region_count++;
+    allocator->region_bytes += region_size - sizeof(Region);
+    allocator->next_region_size = region_next_size(region_size);
+
+    Block *block = (Block *) (region + 1);
+    block->size = region_size - sizeof(Region) - sizeof(Block);
+    block->next = allocator->free_list;
+    block->is_free = 1;
+    allocator->free_list = block;
+
+    allocator->free_bytes += block->size;
+    free_block_add(allocator, block->size);
+    return block;
+}
+
+static size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Ищет свободный блок, в который помещается size байт с адресом, кратным alignment.
+// Если выравненный адрес не совпадает с началом блока, перед ним отрезается свободный блок
+static Block *find_block(Allocator *allocator, size_t size, size_t alignment) {
+    for (Block *curr = allocator->free_list; curr != NULL; curr = curr->next) {
+        if (!curr->is_free || curr->size < size) {
+            continue;
+        }
+
+        uintptr_t payload = (uintptr_t) (curr + 1);
+        uintptr_t aligned = align_up(payload, alignment);
+        while (aligned != payload && aligned - payload < sizeof(Block) + 1) {
+            aligned += alignment;
+        }
+        size_t gap = aligned - payload;
+        if (gap + size > curr->size) {
+            continue;
+        }
+        if (gap == 0) {
+            return curr;
+        }
+
+        Block *block = (Block *) aligned - 1;
+        free_block_remove(allocator, curr->size);
+        block->size = curr->size - gap;
+        block->next = curr->next;
+        block->is_free = 1;
+        curr->size = gap - sizeof(Block);
+        curr->next = block;
+        allocator->free_bytes -= sizeof(Block);
+        free_block_add(allocator, curr->size);
+        free_block_add(allocator, block->size);
+        return block;
+    }
+    return NULL;
+}
+
+// Отрезает от занятого блока хвост после size байт и сливает его со следующим свободным
+static void split_tail(Allocator *allocator, Block *block, size_t size) {
+    if (block->size < size + sizeof(Block) + 1) {
+        return;
+    }
+
+    Block *tail = (Block *) ((char *) (block + 1) + size);
+    tail->size = block->size - size - sizeof(Block);
+    tail->next = block->next;
+    tail->is_free = 1;
+    allocator->used_bytes -= block->size - size;
+    allocator->free_bytes += tail->size;
+    block->size = size;
+    block->next = tail;
+
+    Block *next = tail->next;
+    if (next != NULL && next->is_free && (char *) (tail + 1) + tail->size == (char *) next) {
+        free_block_remove(allocator, next->size);
+        tail->size += sizeof(Block) + next->size;
+        tail->next = next->next;
+        allocator->free_bytes += sizeof(Block);
+    }
+    free_block_add(allocator, tail->size);
+}
+
+void *allocator_alloc_aligned(Allocator *allocator, size_t size, size_t alignment) {
+    if(allocator == NULL){
+        return NULL;
+    }
+    if(size > REGION_MAX_SIZE || alignment == 0 || alignment > REGION_MAX_SIZE || (alignment & (alignment - 1)) != 0){
+        allocator->failed_allocs++;
+        return NULL;
+    }
+    if (alignment < BLOCK_ALIGNMENT) {
+        alignment = BLOCK_ALIGNMENT;
+    }
+    size = align_up(size, BLOCK_ALIGNMENT);
+
+    Block *curr = find_block(allocator, size, alignment);
+    if (curr == NULL) {
+        // Новая область с запасом под отрезаемый перед выравненным адресом блок
+        if (allocator_grow(allocator, size + alignment + sizeof(Block)) == NULL) {
+            allocator->failed_allocs++;
+            return NULL;
+        }
+        curr = find_block(allocator, size, alignment);
+    }
+
+    free_block_remove(allocator, curr->size);
+    allocator->free_bytes -= curr->size;
+    allocator->used_bytes += curr->size;
+    curr->is_free = 0;
+    split_tail(allocator, curr, size);
+
+    allocator->alloc_count++;
+    allocator->class_used[allocator_stats_class(curr->size)]++;
+    return (void *) (curr + 1);
+}
+
+void *allocator_alloc(Allocator *allocator, size_t size) {
+    TRACE_SCOPE("allocator_alloc");
+    return allocator_alloc_aligned(allocator, size, BLOCK_ALIGNMENT);
+}
+
+void *allocator_calloc(Allocator *allocator, size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        if (allocator != NULL) {
+            allocator->failed_allocs++;
+        }
+        return NULL;
+    }
+    void *memory = allocator_alloc(allocator, count * size);
+    if (memory != NULL) {
+        memset(memory, 0, count * size);
+    }
+    return memory;
+}
+
+void *allocator_realloc(Allocator *allocator, void *ptr, size_t size) {
+    if (ptr == NULL) {
+        return allocator_alloc(allocator, size);
+    }
+    if (size > REGION_MAX_SIZE) {
+        allocator->failed_allocs++;
+        return NULL;
+    }
+
+    Block *block = (Block *) ptr - 1;
+    size_t old_size = block->size;
+    size_t new_size = align_up(size, BLOCK_ALIGNMENT);
+
+    // Рост на месте: поглощаем следующий свободный блок, если он вплотную и его хватает
+    Block *next = block->next;
+    if (new_size > block->size && next != NULL && next->is_free &&
+        (char *) (block + 1) + block->size == (char *) next &&
+        block->size + sizeof(Block) + next->size >= new_size) {
+        free_block_remove(allocator, next->size);
+        allocator->free_bytes -= next->size;
+        allocator->used_bytes += sizeof(Block) + next->size;
+        block->size += sizeof(Block) + next->size;
+        block->next = next->next;
+    }
+
+    if (new_size <= block->size) {
+        split_tail(allocator, block, new_size);
+        allocator->class_used[allocator_stats_class(old_size)]--;
+        allocator->class_used[allocator_stats_class(block->size)]++;
+        return ptr;
+    }
+
+    void *memory = allocator_alloc(allocator, size);
+    if (memory == NULL) {
+        return NULL;
+    }
+    memcpy(memory, ptr, block->size);
+    allocator_free(allocator, ptr);
+    return memory;
+}
+
+size_t allocator_usable_size(Allocator *allocator, void *ptr) {
+    (void) allocator;
+    return ptr == NULL ? 0 : ((Block *) ptr - 1)->size;
+}
+
+// Если область, содержащая block, целиком свободна - отдаём её страницы системе
+static void release_idle_region(Allocator *allocator, Block *block) {
+    for (Region *region = allocator->regions; region != NULL; region = region->next) {
+        char *start = (char *) region;
+        if ((char *) block < start || (char *) block >= start + region->size) {
+            continue;
+        }
+        Block *first = (Block *) (region + 1);
+        if (first->is_free && first->size == region->size - sizeof(Region) - sizeof(Block)) {
+            region_release(first + 1, start + region->size);
+        }
+        return;
+    }
+}
+
+void allocator_free(Allocator *allocator, void *ptr) {
+    TRACE_SCOPE("allocator_free");
+    if (ptr == NULL) return;
+
+    Block *block = (Block *) ptr - 1;
+    if (block->is_free) return;
+    block->is_free = 1;
+
+    allocator->used_bytes -= block->size;
+    allocator->free_bytes += block->size;
+    allocator->free_count++;
+    allocator->class_used[allocator_stats_class(block->size)]--;
+    free_block_add(allocator, block->size);
+
+    // Соседние в списке блоки разных областей не смежны в памяти и не сливаются
+    Block *curr = allocator->free_list;
+    while (curr != NULL) {
+        if (curr->is_free && curr->next != NULL && curr->next->is_free &&
+            (char *) (curr + 1) + curr->size == (char *) curr->next) {
+            free_block_remove(allocator, curr->size);
+            free_block_remove(allocator, curr->next->size);
+            curr->size += sizeof(Block) + curr->next->size;
+            curr->next = curr->next->next;
+            allocator->free_bytes += sizeof(Block);
+            free_block_add(allocator, curr->size);
+            continue;
+        }
+        curr = curr->next;
+    }
+
+    release_idle_region(allocator, block);
+}
+
+void allocator_destroy(Allocator* allocator) {
+    Region *region = allocator->regions;
+    while (region != NULL) {
+        Region *next = region->next;
+        munmap(region, region->size);
+        region = next;
+    }
+    if (munmap(allocator, allocator->size + sizeof(Allocator)) == -1) {
+        perror("munmap failed");
+    }
+}
+
+void allocator_stats(Allocator *allocator, AllocatorStats *stats) {
+    if (allocator == NULL || stats == NULL) {
+        return;
+    }
+
+    // Наибольший блок лежит в старшем непустом классе (2^(i-1), 2^i] - берём его нижнюю границу,
+    // запрос такого размера точно пройдёт. Единственный свободный блок известен точно: это free_bytes
+    size_t largest = 0;
+    size_t blocks = 0;
+    for (size_t i = FREE_BLOCK_CLASSES; i-- > 0;) {
+        if (allocator->free_blocks[i] > 0 && blocks == 0) {
+            largest = i == 0 ? 0 : ((size_t) 1 << (i - 1)) + 1;
+        }
+        blocks += allocator->free_blocks[i];
+    }
+    if (blocks == 1) {
+        largest = allocator->free_bytes;
+    }
+
+    stats->total_bytes = allocator->size + allocator->region_bytes;
+    stats->region_count = allocator->region_count;
+    stats->used_bytes = allocator->used_bytes;
+    stats->free_bytes = allocator->free_bytes;
+    stats->largest_free_block = largest;
+    stats->alloc_count = allocator->alloc_count;
+    stats->free_count = allocator->free_count;
+    stats->failed_allocs = allocator->failed_allocs;
+    memcpy(stats->class_used, allocator->class_used, sizeof(stats->class_used));
 }
\ No newline at end of file
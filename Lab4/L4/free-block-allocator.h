@@ -1,28 +1,64 @@
-#pragma once
-
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <stdint.h>
-#include <sys/mman.h>
-#include <string.h>
-
-typedef struct Block {
-    size_t size;
-    struct Block *next;
-    int is_free;
-} Block;
-
-typedef struct {
-    Block *free_list;
-    void *memory;
-    size_t size;
-} Allocator;
-
-Allocator *allocator_create(void *const memory, const size_t size);
-
-void *allocator_alloc(Allocator *allocator, size_t size);
-
-void allocator_free(Allocator *allocator, void *ptr);
-
-void allocator_destroy(Allocator *allocator);
\ No newline at end of file
+#pragma once
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <string.h>
+
+#include "allocator-stats.h"
+#include "region.h"
+
+#define BLOCK_ALIGNMENT sizeof(size_t)
+#define FREE_BLOCK_CLASSES 64  // Классы allocator_size_class для любого size_t
+
+typedef struct Block {
+    size_t size;
+    struct Block *next;
+    int is_free;
+} Block;
+
+// Заголовок дополнительной области, за ним сразу идёт первый Block
+typedef struct Region {
+    size_t size;
+    struct Region *next;
+} Region;
+
+typedef struct {
+    Block *free_list;
+    void *memory;
+    size_t size;
+
+    Region *regions;
+    size_t region_count;
+    size_t next_region_size;
+    size_t region_bytes;
+
+    // Счётчики для allocator_stats, обновляются в alloc/free
+    size_t used_bytes;
+    size_t free_bytes;
+    size_t free_blocks[FREE_BLOCK_CLASSES];  // Свободных блоков в классе - наибольший без обхода списка
+    size_t alloc_count;
+    size_t free_count;
+    size_t failed_allocs;
+    size_t class_used[ALLOCATOR_STATS_CLASSES];
+} Allocator;
+
+Allocator *allocator_create(void *const memory, const size_t size);
+
+void *allocator_alloc(Allocator *allocator, size_t size);
+
+void *allocator_alloc_aligned(Allocator *allocator, size_t size, size_t alignment);
+
+void *allocator_realloc(Allocator *allocator, void *ptr, size_t size);
+
+void *allocator_calloc(Allocator *allocator, size_t count, size_t size);
+
+size_t allocator_usable_size(Allocator *allocator, void *ptr);
+
+void allocator_free(Allocator *allocator, void *ptr);
+
+void allocator_destroy(Allocator *allocator);
+
+void allocator_stats(Allocator *allocator, AllocatorStats *stats);
\ No newline at end of file
@@ -1,155 +1,355 @@
-#include <stdio.h>
-#include <dlfcn.h>
-#include <sys/mman.h>
-
-#include "errors.h"
-
-#define MEMORY_SIZE 1024 * 1024
-
-typedef struct Allocator Allocator;
-
-typedef Allocator *create_allocator_func(void *memory, size_t size);
-
-typedef void *allocator_alloc_func(Allocator *const allocator, const size_t size);
-
-typedef void allocator_free_func(Allocator *const allocator, void *const memory);
-
-typedef void allocator_destroy_func(Allocator *const allocator);
-
-static create_allocator_func *create_allocator;
-static allocator_alloc_func *allocator_alloc;
-static allocator_free_func *allocator_free;
-static allocator_destroy_func *allocator_destroy;
-
-int print_error(error_msg error) {
-    char buffer[100];
-    if (error.type) {
-        snprintf(buffer, 100, "Error - %s: %s\n", error.func, error.msg);
-        write(STDERR_FILENO, buffer, strlen(buffer));
-        return error.type;
-    }
-    return 0;
-}
-
-error_msg init_library(void *library) {
-    create_allocator = dlsym(library, "allocator_create");
-    if (create_allocator == NULL) {
-        dlclose(library);
-        return (error_msg) {INCORRECT_OPTIONS_ERROR, "main", "failed to find create function"};
-    }
-
-    allocator_alloc = dlsym(library, "allocator_alloc");
-    if (allocator_alloc == NULL) {
-        dlclose(library);
-        return (error_msg) {INCORRECT_OPTIONS_ERROR, "main", "failed to find alloc function"};
-    }
-
-    allocator_free = dlsym(library, "allocator_free");
-    if (allocator_free == NULL) {
-        dlclose(library);
-        return (error_msg) {INCORRECT_OPTIONS_ERROR, "main", "failed to find free function"};
-    }
-
-    allocator_destroy = dlsym(library, "allocator_destroy");
-    if (allocator_destroy == NULL) {
-        dlclose(library);
-        return (error_msg) {INCORRECT_OPTIONS_ERROR, "main", "failed to find destroy function"};
-    }
-    return (error_msg) {SUCCESS, "", ""};
-}
-
-
-int main(int argc, char **argv) {
-    void *library = NULL;
-
-    if (argc == 2) {
-        library = dlopen(argv[1], RTLD_LOCAL | RTLD_NOW);
-    }
-    if (argc != 2 || library == NULL) {
-        library = dlopen("./libfree-block-allocator.so", RTLD_GLOBAL | RTLD_LAZY);
-    }
-    if (library == NULL) {
-        return print_error((error_msg) {INCORRECT_OPTIONS_ERROR, "main", "incorrect count args"});
-    }
-    void *memory = mmap(
-            NULL, MEMORY_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
-    );
-
-    if (memory == MAP_FAILED) {
-        return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "map"});
-    }
-
-    error_msg errorMsg = init_library(library);
-    if(errorMsg.type){
-        dlclose(library);
-        return print_error(errorMsg);
-    }
-
-    Allocator * allocator = create_allocator(memory, MEMORY_SIZE);
-    if(allocator == NULL){
-        return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "allocator didn't create"});
-    }
-
-    // Тест 1: Выделение и освобождение памяти
-    printf("Test 1: Allocating and freeing memory...\n");
-    int *a = allocator_alloc(allocator, sizeof(int) * 10);
-    if (a == NULL) {
-        return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "memory allocated"});
-    }
-    a[0] = 13;
-    a[9] = 19;
-    printf("a[0] = %d, a[9] = %d\n", a[0], a[9]);
-    allocator_free(allocator, a);
-    printf("Test 1 passed.\n\n");
-
-    // Тест 2: Выделение памяти большего размера
-    printf("Test 2: Allocating larger memory block...\n");
-    int *b = allocator_alloc(allocator, sizeof(int) * 1000);
-    if (b == NULL) {
-        return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "memory allocated"});
-    }
-    b[0] = 42;
-    b[999] = 24;
-    printf("b[0] = %d, b[999] = %d\n", b[0], b[999]);
-    allocator_free(allocator, b);
-    printf("Test 2 passed.\n\n");
-
-    // Тест 3: Повторное выделение памяти после освобождения
-    printf("Test 3: Reallocating memory after freeing...\n");
-    int *c = allocator_alloc(allocator, sizeof(int) * 5);
-    if (c == NULL) {
-        return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "memory allocated"});
-    }
-    c[0] = 7;
-    c[4] = 14;
-    printf("c[0] = %d, c[4] = %d\n", c[0], c[4]);
-    allocator_free(allocator, c);
-    printf("Test 3 passed.\n\n");
-
-    // Тест 4: Попытка выделения слишком большого блока памяти
-    printf("Test 4: Attempting to allocate too much memory...\n");
-    int *d = allocator_alloc(allocator, MEMORY_SIZE + 1); // Попытка выделить больше, чем доступно
-    if (d != NULL) {
-        return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "memory allocated unexpectedly"});
-    }
-    printf("Test 4 passed (expected failure).\n\n");
-
-    // Тест 5: Выделение нескольких блоков памяти
-    printf("Test 5: Allocating multiple memory blocks...\n");
-    int *e = allocator_alloc(allocator, sizeof(int) * 10);
-    int *f = allocator_alloc(allocator, sizeof(int) * 20);
-    if (e == NULL || f == NULL) {
-        return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "memory allocated"});
-    }
-    e[0] = 1;
-    f[0] = 2;
-    printf("e[0] = %d, f[0] = %d\n", e[0], f[0]);
-    allocator_free(allocator, e);
-    allocator_free(allocator, f);
-    printf("Test 5 passed.\n\n");
-
-    allocator_destroy(allocator);
-
-    dlclose(library);
-    return 0;
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <sys/mman.h>
+
+#include "errors.h"
+#include "allocator-stats.h"
+#include "allocator-fast.h"
+
+#define MEMORY_SIZE 1024 * 1024
+#define TOO_LARGE_SIZE ((size_t) 1 << 62)
+#define GROWTH_BLOCK_SIZE 2048
+#define GROWTH_BLOCKS (2 * MEMORY_SIZE / GROWTH_BLOCK_SIZE)
+#define FAST_TEST_BLOCKS 200
+#define FAST_TEST_PAIRS 1000000
+
+typedef struct Allocator Allocator;
+
+typedef Allocator *create_allocator_func(void *memory, size_t size);
+
+typedef void *allocator_alloc_func(Allocator *const allocator, const size_t size);
+
+typedef void allocator_free_func(Allocator *const allocator, void *const memory);
+
+typedef void allocator_destroy_func(Allocator *const allocator);
+
+typedef void *allocator_alloc_aligned_func(Allocator *const allocator, const size_t size, const size_t alignment);
+
+typedef void *allocator_realloc_func(Allocator *const allocator, void *const memory, const size_t size);
+
+typedef void *allocator_calloc_func(Allocator *const allocator, const size_t count, const size_t size);
+
+typedef void allocator_stats_func(Allocator *const allocator, AllocatorStats *const stats);
+
+static create_allocator_func *create_allocator;
+static allocator_alloc_func *allocator_alloc;
+static allocator_free_func *allocator_free;
+static allocator_destroy_func *allocator_destroy;
+// Необязательные функции, могут отсутствовать в библиотеке
+static allocator_alloc_aligned_func *allocator_alloc_aligned;
+static allocator_realloc_func *allocator_realloc;
+static allocator_calloc_func *allocator_calloc;
+static allocator_stats_func *allocator_stats;
+
+int print_error(error_msg error) {
+    char buffer[100];
+    if (error.type) {
+        snprintf(buffer, 100, "Error - %s: %s\n", error.func, error.msg);
+        write(STDERR_FILENO, buffer, strlen(buffer));
+        return error.type;
+    }
+    return 0;
+}
+
+void print_stats(Allocator *allocator) {
+    if (allocator_stats == NULL) {
+        return;
+    }
+    AllocatorStats stats;
+    allocator_stats(allocator, &stats);
+    printf("Stats: total %zu in %zu extra regions, used %zu, free %zu, largest free %zu\n",
+           stats.total_bytes, stats.region_count, stats.used_bytes, stats.free_bytes, stats.largest_free_block);
+    printf("Stats: allocs %zu, frees %zu, failed %zu\n",
+           stats.alloc_count, stats.free_count, stats.failed_allocs);
+    printf("Stats: live blocks per class:");
+    for (size_t i = 0; i < ALLOCATOR_STATS_CLASSES; i++) {
+        if (stats.class_used[i] > 0) {
+            printf(" [%zu]=%zu", i, stats.class_used[i]);
+        }
+    }
+    printf("\n\n");
+}
+
+// Поток берёт блоки через кэш и завершается без fast_flush - блоки вернёт деструктор ключа
+void *fast_thread(void *arg) {
+    FastBackend *fast = arg;
+    void *blocks[FAST_TEST_BLOCKS];
+    for (size_t i = 0; i < FAST_TEST_BLOCKS; i++) {
+        blocks[i] = fast_alloc(fast, 64);
+    }
+    for (size_t i = 0; i < FAST_TEST_BLOCKS; i++) {
+        fast_free(fast, blocks[i], 64);
+    }
+    return NULL;
+}
+
+double now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+error_msg init_library(void *library) {
+    create_allocator = dlsym(library, "allocator_create");
+    if (create_allocator == NULL) {
+        dlclose(library);
+        return (error_msg) {INCORRECT_OPTIONS_ERROR, "main", "failed to find create function"};
+    }
+
+    allocator_alloc = dlsym(library, "allocator_alloc");
+    if (allocator_alloc == NULL) {
+        dlclose(library);
+        return (error_msg) {INCORRECT_OPTIONS_ERROR, "main", "failed to find alloc function"};
+    }
+
+    allocator_free = dlsym(library, "allocator_free");
+    if (allocator_free == NULL) {
+        dlclose(library);
+        return (error_msg) {INCORRECT_OPTIONS_ERROR, "main", "failed to find free function"};
+    }
+
+    allocator_destroy = dlsym(library, "allocator_destroy");
+    if (allocator_destroy == NULL) {
+        dlclose(library);
+        return (error_msg) {INCORRECT_OPTIONS_ERROR, "main", "failed to find destroy function"};
+    }
+
+    allocator_alloc_aligned = dlsym(library, "allocator_alloc_aligned");
+    allocator_realloc = dlsym(library, "allocator_realloc");
+    allocator_calloc = dlsym(library, "allocator_calloc");
+    allocator_stats = dlsym(library, "allocator_stats");
+    return (error_msg) {SUCCESS, "", ""};
+}
+
+
+int main(int argc, char **argv) {
+    void *library = NULL;
+
+    if (argc == 2) {
+        library = dlopen(argv[1], RTLD_LOCAL | RTLD_NOW);
+    }
+    if (argc != 2 || library == NULL) {
+        library = dlopen("./libfree-block-allocator.so", RTLD_GLOBAL | RTLD_LAZY);
+    }
+    if (library == NULL) {
+        return print_error((error_msg) {INCORRECT_OPTIONS_ERROR, "main", "incorrect count args"});
+    }
+    void *memory = mmap(
+            NULL, MEMORY_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+    );
+
+    if (memory == MAP_FAILED) {
+        return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "map"});
+    }
+
+    error_msg errorMsg = init_library(library);
+    if(errorMsg.type){
+        dlclose(library);
+        return print_error(errorMsg);
+    }
+
+    Allocator * allocator = create_allocator(memory, MEMORY_SIZE);
+    if(allocator == NULL){
+        return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "allocator didn't create"});
+    }
+
+    // Тест 1: Выделение и освобождение памяти
+    printf("Test 1: Allocating and freeing memory...\n");
+    int *a = allocator_alloc(allocator, sizeof(int) * 10);
+    if (a == NULL) {
+        return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "memory allocated"});
+    }
+    a[0] = 13;
+    a[9] = 19;
+    printf("a[0] = %d, a[9] = %d\n", a[0], a[9]);
+    allocator_free(allocator, a);
+    printf("Test 1 passed.\n\n");
+
+    // Тест 2: Выделение памяти большего размера
+    printf("Test 2: Allocating larger memory block...\n");
+    int *b = allocator_alloc(allocator, sizeof(int) * 1000);
+    if (b == NULL) {
+        return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "memory allocated"});
+    }
+    b[0] = 42;
+    b[999] = 24;
+    printf("b[0] = %d, b[999] = %d\n", b[0], b[999]);
+    allocator_free(allocator, b);
+    printf("Test 2 passed.\n\n");
+
+    // Тест 3: Повторное выделение памяти после освобождения
+    printf("Test 3: Reallocating memory after freeing...\n");
+    int *c = allocator_alloc(allocator, sizeof(int) * 5);
+    if (c == NULL) {
+        return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "memory allocated"});
+    }
+    c[0] = 7;
+    c[4] = 14;
+    printf("c[0] = %d, c[4] = %d\n", c[0], c[4]);
+    allocator_free(allocator, c);
+    printf("Test 3 passed.\n\n");
+
+    // Тест 4: Попытка выделения слишком большого блока памяти
+    printf("Test 4: Attempting to allocate too much memory...\n");
+    int *d = allocator_alloc(allocator, TOO_LARGE_SIZE); // Попытка выделить больше, чем можно отобразить
+    if (d != NULL) {
+        return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "memory allocated unexpectedly"});
+    }
+    printf("Test 4 passed (expected failure).\n\n");
+
+    // Тест 5: Выделение нескольких блоков памяти
+    printf("Test 5: Allocating multiple memory blocks...\n");
+    int *e = allocator_alloc(allocator, sizeof(int) * 10);
+    int *f = allocator_alloc(allocator, sizeof(int) * 20);
+    if (e == NULL || f == NULL) {
+        return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "memory allocated"});
+    }
+    e[0] = 1;
+    f[0] = 2;
+    printf("e[0] = %d, f[0] = %d\n", e[0], f[0]);
+    print_stats(allocator);
+    allocator_free(allocator, e);
+    allocator_free(allocator, f);
+    printf("Test 5 passed.\n\n");
+
+    print_stats(allocator);
+
+    // Тест 6: Выделение больше MEMORY_SIZE - аллокатор должен отобразить новые области
+    printf("Test 6: Growing past the initial region...\n");
+    static char *blocks[GROWTH_BLOCKS];
+    for (size_t i = 0; i < GROWTH_BLOCKS; i++) {
+        blocks[i] = allocator_alloc(allocator, GROWTH_BLOCK_SIZE);
+        if (blocks[i] == NULL) {
+            return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "memory allocated"});
+        }
+        blocks[i][0] = (char) i;
+        blocks[i][GROWTH_BLOCK_SIZE - 1] = (char) i;
+    }
+    for (size_t i = 0; i < GROWTH_BLOCKS; i++) {
+        if (blocks[i][0] != (char) i || blocks[i][GROWTH_BLOCK_SIZE - 1] != (char) i) {
+            return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "memory corrupted"});
+        }
+    }
+    print_stats(allocator);
+    for (size_t i = 0; i < GROWTH_BLOCKS; i++) {
+        allocator_free(allocator, blocks[i]);
+    }
+    printf("Test 6 passed.\n\n");
+
+    print_stats(allocator);
+
+    // Тест 7: Выравнивание по 64 байта для векторных буферов
+    if (allocator_alloc_aligned != NULL) {
+        printf("Test 7: Allocating 64-byte aligned memory...\n");
+        char *pad = allocator_alloc(allocator, 1);
+        float *g = allocator_alloc_aligned(allocator, sizeof(float) * 16, 64);
+        if (g == NULL || (uintptr_t) g % 64 != 0) {
+            return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "aligned memory allocated"});
+        }
+        g[0] = 1.5f;
+        g[15] = 2.5f;
+        printf("g[0] = %.1f, g[15] = %.1f\n", g[0], g[15]);
+        allocator_free(allocator, g);
+        allocator_free(allocator, pad);
+        printf("Test 7 passed.\n\n");
+    }
+
+    // Тест 8: Увеличение блока с сохранением содержимого
+    if (allocator_realloc != NULL) {
+        printf("Test 8: Reallocating to a larger block...\n");
+        int *h = allocator_alloc(allocator, sizeof(int) * 10);
+        if (h == NULL) {
+            return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "memory allocated"});
+        }
+        for (int i = 0; i < 10; i++) {
+            h[i] = i * i;
+        }
+        int *grown = allocator_realloc(allocator, h, sizeof(int) * 500);
+        if (grown == NULL || grown[3] != 9 || grown[9] != 81) {
+            return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "memory reallocated"});
+        }
+        grown[499] = 5;
+        printf("grown[9] = %d, grown[499] = %d, %s\n", grown[9], grown[499], grown == h ? "in place" : "moved");
+        allocator_free(allocator, grown);
+        printf("Test 8 passed.\n\n");
+    }
+
+    // Тест 9: Выделение обнулённой памяти
+    if (allocator_calloc != NULL) {
+        printf("Test 9: Allocating zeroed memory...\n");
+        int *k = allocator_calloc(allocator, 100, sizeof(int));
+        if (k == NULL || k[0] != 0 || k[99] != 0) {
+            return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "zeroed memory allocated"});
+        }
+        printf("k[0] = %d, k[99] = %d\n", k[0], k[99]);
+        allocator_free(allocator, k);
+        printf("Test 9 passed.\n\n");
+    }
+
+    print_stats(allocator);
+
+    // Тест 10: Встраиваемый фронтенд - класс по константному размеру, кэш потока
+    printf("Test 10: Inline fast path over the selected backend...\n");
+    FastBackend fast;
+    if (fast_backend_init(&fast, allocator, allocator_alloc, allocator_free) != 0) {
+        return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "fast backend init"});
+    }
+    static long *small[FAST_TEST_BLOCKS];
+    for (size_t i = 0; i < FAST_TEST_BLOCKS; i++) {
+        small[i] = fast_alloc(&fast, sizeof(long) * 3);
+        if (small[i] == NULL) {
+            return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "fast memory allocated"});
+        }
+        small[i][0] = (long) i;
+        small[i][2] = -(long) i;
+    }
+    for (size_t i = 0; i < FAST_TEST_BLOCKS; i++) {
+        if (small[i][0] != (long) i || small[i][2] != -(long) i) {
+            return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "fast memory corrupted"});
+        }
+        fast_free(&fast, small[i], sizeof(long) * 3);
+    }
+
+    double start = now_ns();
+    for (long i = 0; i < FAST_TEST_PAIRS; i++) {
+        volatile long *pair = allocator_alloc(allocator, 32);
+        pair[0] = i;
+        allocator_free(allocator, (void *) pair);
+    }
+    double direct = (now_ns() - start) / FAST_TEST_PAIRS;
+    start = now_ns();
+    for (long i = 0; i < FAST_TEST_PAIRS; i++) {
+        volatile long *pair = fast_alloc(&fast, 32);
+        pair[0] = i;
+        fast_free(&fast, (void *) pair, 32);
+    }
+    double inlined = (now_ns() - start) / FAST_TEST_PAIRS;
+    printf("alloc/free pair of 32 bytes: %.2f ns through dlsym, %.2f ns inline\n", direct, inlined);
+
+    fast_flush();
+
+    if (allocator_stats != NULL) {
+        AllocatorStats before, after;
+        allocator_stats(allocator, &before);
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, fast_thread, &fast) != 0 || pthread_join(thread, NULL) != 0) {
+            return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "fast thread"});
+        }
+        allocator_stats(allocator, &after);
+        if (after.used_bytes != before.used_bytes) {
+            return print_error((error_msg) {MEMORY_ALLOCATED_ERROR, "main", "thread cache leaked on exit"});
+        }
+        printf("Thread cache returned to the backend on thread exit\n");
+    }
+    fast_backend_destroy(&fast);
+    printf("Test 10 passed.\n\n");
+
+    print_stats(allocator);
+
+    allocator_destroy(allocator);
+
+    dlclose(library);
+    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,536 @@
+// Библиотека для LD_PRELOAD: подменяет malloc/free/realloc/calloc/posix_memalign
+// и направляет их в аллокатор из Lab4. Аллокатор должен экспортировать
+// allocator_realloc и allocator_usable_size, вызовы сериализуются одним мьютексом.
+//
+// Сборка:  gcc -shared -fPIC -O2 -o libmalloc-shim.so malloc-shim.c -ldl -pthread
+// Запуск:  ALLOCATOR_LIB=./libmccusIcarels-algorithm.so LD_PRELOAD=./libmalloc-shim.so ./program
+//
+// ALLOCATOR_LIB        - библиотека аллокатора (по умолчанию ./libfree-block-allocator.so)
+// ALLOCATOR_ARENA_SIZE - размер начальной области в байтах (по умолчанию 64 МиБ)
+//
+// Если библиотеку аллокатора загрузить не удалось, вызовы уходят в malloc из glibc (RTLD_NEXT).
+//
+// Сравнение с glibc: запустить программу под /usr/bin/time -v с LD_PRELOAD и без него
+// и сравнить время и "Maximum resident set size".
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sched.h>
+#include <string.h>
+#include <errno.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define DEFAULT_LIB "./libfree-block-allocator.so"
+#define DEFAULT_ARENA_SIZE (64 * 1024 * 1024)
+#define BOOTSTRAP_SIZE (256 * 1024)
+#define BOOTSTRAP_ALIGN 16
+#define LARGE_TABLE_MIN_SIZE 1024
+#define SHIM_ALIGN _Alignof(max_align_t)  // Выравнивание, которое malloc обязан гарантировать
+
+typedef struct Allocator Allocator;
+
+typedef Allocator *create_allocator_func(void *memory, size_t size);
+
+typedef void *allocator_alloc_func(Allocator *const allocator, const size_t size);
+
+typedef void allocator_free_func(Allocator *const allocator, void *const memory);
+
+typedef void *allocator_alloc_aligned_func(Allocator *const allocator, const size_t size, const size_t alignment);
+
+typedef void *allocator_realloc_func(Allocator *const allocator, void *const memory, const size_t size);
+
+typedef size_t allocator_usable_size_func(Allocator *const allocator, void *const memory);
+
+typedef void *next_malloc_func(size_t size);
+
+typedef void next_free_func(void *ptr);
+
+typedef void *next_realloc_func(void *ptr, size_t size);
+
+typedef int next_posix_memalign_func(void **memptr, size_t alignment, size_t size);
+
+typedef size_t next_usable_size_func(void *ptr);
+
+enum shim_state {
+    SHIM_UNINITIALIZED,
+    SHIM_INITIALIZING,
+    SHIM_READY,
+    SHIM_FAILED
+};
+
+static allocator_alloc_func *backend_alloc;
+static allocator_free_func *backend_free;
+static allocator_alloc_aligned_func *backend_alloc_aligned;
+static allocator_realloc_func *backend_realloc;
+static allocator_usable_size_func *backend_usable_size;
+static Allocator *allocator;
+
+// Функции glibc на случай, если аллокатор не загрузился
+static next_malloc_func *next_malloc;
+static next_free_func *next_free;
+static next_realloc_func *next_realloc;
+static next_posix_memalign_func *next_posix_memalign;
+static next_usable_size_func *next_usable_size;
+
+static int state = SHIM_UNINITIALIZED;
+static pthread_mutex_t shim_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Поток, который сейчас загружает аллокатор: его вложенные вызовы идут в буфер начальной загрузки.
+// initial-exec - статический TLS, обращение к нему не вызывает malloc
+static __thread int shim_initializing __attribute__((tls_model("initial-exec")));
+
+// Пока грузится библиотека аллокатора, dlopen сам вызывает malloc -
+// такие запросы обслуживаются простым сдвигом указателя в статическом буфере
+static _Alignas(BOOTSTRAP_ALIGN) char bootstrap[BOOTSTRAP_SIZE];
+static size_t bootstrap_used;
+
+// Запросы, от которых отказался аллокатор (например, больше страницы у McKusick-Karels),
+// отображаются отдельно; их адреса хранятся в открытой хеш-таблице. Удалённые записи
+// помечаются адресом LARGE_TOMBSTONE, занимаются заново при вставке и выбрасываются
+// при перестроении таблицы
+#define LARGE_EMPTY ((uintptr_t) 0)
+#define LARGE_TOMBSTONE ((uintptr_t) 1)
+
+typedef struct LargeEntry {
+    uintptr_t address;
+    size_t size;
+} LargeEntry;
+
+static LargeEntry *large_table;
+static size_t large_capacity;  // Степень двойки
+static size_t large_count;
+static size_t large_tombstones;
+
+static void shim_error(const char *message) {
+    const char prefix[] = "malloc-shim: ";
+    write(STDERR_FILENO, prefix, sizeof(prefix) - 1);
+    write(STDERR_FILENO, message, strlen(message));
+    write(STDERR_FILENO, "\n", 1);
+}
+
+static int in_bootstrap(void *ptr) {
+    return (char *) ptr >= bootstrap && (char *) ptr < bootstrap + BOOTSTRAP_SIZE;
+}
+
+static void *bootstrap_alloc(size_t size) {
+    size_t offset = __atomic_fetch_add(&bootstrap_used, BOOTSTRAP_ALIGN + ((size + BOOTSTRAP_ALIGN - 1) & ~(size_t) (BOOTSTRAP_ALIGN - 1)), __ATOMIC_RELAXED);
+    if (offset + BOOTSTRAP_ALIGN + size > BOOTSTRAP_SIZE) {
+        return NULL;
+    }
+    *(size_t *) (bootstrap + offset) = size;
+    return bootstrap + offset + BOOTSTRAP_ALIGN;
+}
+
+static size_t bootstrap_size(void *ptr) {
+    return *(size_t *) ((char *) ptr - BOOTSTRAP_ALIGN);
+}
+
+static size_t large_slot(uintptr_t address) {
+    return (size_t) ((address >> 12) * 0x9E3779B97F4A7C15ull) & (large_capacity - 1);
+}
+
+static LargeEntry *large_find(void *ptr) {
+    if (large_count == 0) {
+        return NULL;
+    }
+    for (size_t i = large_slot((uintptr_t) ptr), n = 0; n < large_capacity; i = (i + 1) & (large_capacity - 1), n++) {
+        if (large_table[i].address == (uintptr_t) ptr) {
+            return &large_table[i];
+        }
+        if (large_table[i].address == LARGE_EMPTY) {
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+static void large_insert(uintptr_t address, size_t size) {
+    size_t i = large_slot(address);
+    while (large_table[i].address != LARGE_EMPTY && large_table[i].address != LARGE_TOMBSTONE) {
+        i = (i + 1) & (large_capacity - 1);
+    }
+    if (large_table[i].address == LARGE_TOMBSTONE) {
+        large_tombstones--;
+    }
+    large_table[i].address = address;
+    large_table[i].size = size;
+    large_count++;
+}
+
+// Готовит место под ещё одну запись: занятые и удалённые вместе не больше половины таблицы.
+// Таблица перестраивается без удалённых записей и при необходимости удваивается
+static int large_reserve(void) {
+    if ((large_count + large_tombstones + 1) * 2 <= large_capacity) {
+        return 1;
+    }
+    size_t capacity = large_capacity;
+    while ((large_count + 1) * 4 > capacity) {
+        capacity *= 2;
+    }
+    LargeEntry *table = mmap(NULL, capacity * sizeof(LargeEntry), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (table == MAP_FAILED) {
+        return (large_count + 1) * 2 <= large_capacity;  // Хватит и удалённых записей
+    }
+
+    LargeEntry *old_table = large_table;
+    size_t old_capacity = large_capacity;
+    large_table = table;
+    large_capacity = capacity;
+    large_count = 0;
+    large_tombstones = 0;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_table[i].address != LARGE_EMPTY && old_table[i].address != LARGE_TOMBSTONE) {
+            large_insert(old_table[i].address, old_table[i].size);
+        }
+    }
+    munmap(old_table, old_capacity * sizeof(LargeEntry));
+    return 1;
+}
+
+static void *large_alloc(size_t size, size_t alignment) {
+    if (large_table == NULL || !large_reserve()) {
+        return NULL;
+    }
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    size_t length = (size + alignment + page - 1) & ~(page - 1);
+    char *memory = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return NULL;
+    }
+
+    // Для выравнивания больше страницы отрезаем лишнее в начале отображения
+    char *aligned = (char *) (((uintptr_t) memory + alignment - 1) & ~(uintptr_t) (alignment - 1));
+    if (aligned != memory) {
+        munmap(memory, aligned - memory);
+        length -= aligned - memory;
+    }
+
+    large_insert((uintptr_t) aligned, length);
+    return aligned;
+}
+
+static void large_free(LargeEntry *entry) {
+    munmap((void *) entry->address, entry->size);
+    entry->address = LARGE_TOMBSTONE;  // Поиск идёт дальше этой записи
+    large_count--;
+    large_tombstones++;
+}
+
+static void fork_prepare(void) {
+    pthread_mutex_lock(&shim_mutex);
+}
+
+static void fork_release(void) {
+    pthread_mutex_unlock(&shim_mutex);
+}
+
+// Аллокатор недоступен: дальше работаем через malloc из glibc
+static void shim_fail(const char *message) {
+    shim_error(message);
+    next_malloc = (next_malloc_func *) dlsym(RTLD_NEXT, "malloc");
+    next_free = (next_free_func *) dlsym(RTLD_NEXT, "free");
+    next_realloc = (next_realloc_func *) dlsym(RTLD_NEXT, "realloc");
+    next_posix_memalign = (next_posix_memalign_func *) dlsym(RTLD_NEXT, "posix_memalign");
+    next_usable_size = (next_usable_size_func *) dlsym(RTLD_NEXT, "malloc_usable_size");
+    if (next_malloc == NULL || next_free == NULL || next_realloc == NULL || next_posix_memalign == NULL ||
+        next_usable_size == NULL) {
+        next_malloc = NULL;
+        next_free = NULL;
+        next_realloc = NULL;
+        next_usable_size = NULL;
+        shim_error("glibc malloc not found, only the bootstrap buffer is available");
+    }
+    __atomic_store_n(&state, SHIM_FAILED, __ATOMIC_RELEASE);
+}
+
+static void shim_load(void);
+
+static void shim_init(void) {
+    int expected = SHIM_UNINITIALIZED;
+    if (!__atomic_compare_exchange_n(&state, &expected, SHIM_INITIALIZING, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        // Инициализацию выполняет другой поток - ждём её; сам загрузчик сюда попадает
+        // из dlopen и обслуживается буфером начальной загрузки
+        if (!shim_initializing) {
+            while (__atomic_load_n(&state, __ATOMIC_ACQUIRE) == SHIM_INITIALIZING) {
+                sched_yield();
+            }
+        }
+        return;
+    }
+
+    shim_initializing = 1;
+    shim_load();
+    shim_initializing = 0;
+}
+
+static void shim_load(void) {
+
+    const char *path = getenv("ALLOCATOR_LIB");
+    if (path == NULL || *path == '\0') {
+        path = DEFAULT_LIB;
+    }
+    size_t arena_size = DEFAULT_ARENA_SIZE;
+    const char *arena_env = getenv("ALLOCATOR_ARENA_SIZE");
+    if (arena_env != NULL && atol(arena_env) > 0) {
+        arena_size = (size_t) atol(arena_env);
+    }
+
+    void *library = dlopen(path, RTLD_LOCAL | RTLD_NOW);
+    if (library == NULL) {
+        shim_fail("failed to load allocator library");
+        return;
+    }
+
+    create_allocator_func *create_allocator = dlsym(library, "allocator_create");
+    backend_alloc = dlsym(library, "allocator_alloc");
+    backend_free = dlsym(library, "allocator_free");
+    backend_alloc_aligned = dlsym(library, "allocator_alloc_aligned");
+    backend_realloc = dlsym(library, "allocator_realloc");
+    backend_usable_size = dlsym(library, "allocator_usable_size");
+    if (create_allocator == NULL || backend_alloc == NULL || backend_free == NULL ||
+        backend_realloc == NULL || backend_usable_size == NULL) {
+        shim_fail("allocator library must export create/alloc/free/realloc/usable_size");
+        return;
+    }
+
+    void *memory = mmap(NULL, arena_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    large_capacity = LARGE_TABLE_MIN_SIZE;
+    large_table = mmap(NULL, large_capacity * sizeof(LargeEntry), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED || large_table == MAP_FAILED) {
+        shim_fail("failed to map arena");
+        return;
+    }
+    allocator = create_allocator(memory, arena_size);
+    if (allocator == NULL) {
+        shim_fail("allocator didn't create");
+        return;
+    }
+
+    pthread_atfork(fork_prepare, fork_release, fork_release);
+    __atomic_store_n(&state, SHIM_READY, __ATOMIC_RELEASE);
+}
+
+// Состояние после инициализации: SHIM_READY - аллокатор, SHIM_FAILED - glibc,
+// SHIM_INITIALIZING - буфер начальной загрузки
+static int shim_state(void) {
+    int current = __atomic_load_n(&state, __ATOMIC_ACQUIRE);
+    if (current == SHIM_UNINITIALIZED) {
+        shim_init();
+        current = __atomic_load_n(&state, __ATOMIC_ACQUIRE);
+    }
+    if (current == SHIM_FAILED && next_malloc == NULL) {
+        return SHIM_INITIALIZING;
+    }
+    return current;
+}
+
+// Вызывается под shim_mutex. Без allocator_alloc_aligned размер округляется до кратного
+// выравниванию (классы степеней двойки тогда выровнены сами), а результат проверяется
+static void *locked_alloc(size_t size, size_t alignment) {
+    void *memory = NULL;
+    size = size == 0 ? 1 : size;
+    if (alignment <= sizeof(size_t)) {
+        memory = backend_alloc(allocator, size);
+    } else if (backend_alloc_aligned != NULL) {
+        memory = backend_alloc_aligned(allocator, size, alignment);
+    } else if (alignment <= SHIM_ALIGN) {
+        memory = backend_alloc(allocator, (size + alignment - 1) & ~(alignment - 1));
+        if (memory != NULL && (uintptr_t) memory % alignment != 0) {
+            backend_free(allocator, memory);
+            memory = NULL;
+        }
+    }
+    if (memory == NULL) {
+        memory = large_alloc(size, alignment);
+    }
+    return memory;
+}
+
+static void *shim_alloc(size_t size, size_t alignment) {
+    int current = shim_state();
+    if (current == SHIM_FAILED) {
+        if (alignment <= SHIM_ALIGN) {
+            return next_malloc(size);
+        }
+        void *memory = NULL;
+        return next_posix_memalign(&memory, alignment, size) == 0 ? memory : NULL;
+    }
+    if (current != SHIM_READY) {
+        return alignment <= BOOTSTRAP_ALIGN ? bootstrap_alloc(size) : NULL;
+    }
+
+    pthread_mutex_lock(&shim_mutex);
+    void *memory = locked_alloc(size, alignment);
+    pthread_mutex_unlock(&shim_mutex);
+    return memory;
+}
+
+void *malloc(size_t size) {
+    void *memory = shim_alloc(size, SHIM_ALIGN);
+    if (memory == NULL) {
+        errno = ENOMEM;
+    }
+    return memory;
+}
+
+void free(void *ptr) {
+    if (ptr == NULL || in_bootstrap(ptr)) {
+        return;
+    }
+    int current = __atomic_load_n(&state, __ATOMIC_ACQUIRE);
+    if (current == SHIM_FAILED && next_free != NULL) {
+        next_free(ptr);
+        return;
+    }
+    if (current != SHIM_READY) {
+        return;
+    }
+
+    pthread_mutex_lock(&shim_mutex);
+    LargeEntry *entry = large_find(ptr);
+    if (entry != NULL) {
+        large_free(entry);
+    } else {
+        backend_free(allocator, ptr);
+    }
+    pthread_mutex_unlock(&shim_mutex);
+}
+
+void *calloc(size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    // Не через malloc: иначе компилятор свернёт malloc + memset обратно в вызов calloc
+    void *memory = shim_alloc(count * size, SHIM_ALIGN);
+    if (memory == NULL) {
+        errno = ENOMEM;
+    } else if (!in_bootstrap(memory)) {
+        memset(memory, 0, count * size);
+    }
+    return memory;
+}
+
+void *realloc(void *ptr, size_t size) {
+    if (ptr == NULL) {
+        return malloc(size);
+    }
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+
+    if (in_bootstrap(ptr)) {
+        void *memory = malloc(size);
+        if (memory != NULL) {
+            size_t old_size = bootstrap_size(ptr);
+            memcpy(memory, ptr, old_size < size ? old_size : size);
+        }
+        return memory;
+    }
+    if (__atomic_load_n(&state, __ATOMIC_ACQUIRE) == SHIM_FAILED && next_realloc != NULL) {
+        return next_realloc(ptr, size);
+    }
+
+    pthread_mutex_lock(&shim_mutex);
+    void *memory = NULL;
+    LargeEntry *entry = large_find(ptr);
+    if (entry == NULL) {
+        memory = backend_realloc(allocator, ptr, size);
+        if (memory == NULL) {
+            // Аллокатор не может дать такой блок - переносим в отдельное отображение
+            memory = large_alloc(size, SHIM_ALIGN);
+            if (memory != NULL) {
+                size_t old_size = backend_usable_size(allocator, ptr);
+                memcpy(memory, ptr, old_size < size ? old_size : size);
+                backend_free(allocator, ptr);
+            }
+        } else if ((uintptr_t) memory % SHIM_ALIGN != 0) {
+            // Аллокатор перенёс блок на адрес с выравниванием хуже, чем требуется от malloc;
+            // старого блока уже нет, поэтому без памяти под копию оставляем как есть
+            void *aligned = locked_alloc(size, SHIM_ALIGN);
+            if (aligned != NULL) {
+                memcpy(aligned, memory, size);
+                backend_free(allocator, memory);
+                memory = aligned;
+            }
+        }
+    } else if (size <= entry->size) {
+        memory = ptr;
+    } else {
+        size_t old_size = entry->size;
+        memory = locked_alloc(size, SHIM_ALIGN);
+        if (memory != NULL) {
+            memcpy(memory, ptr, old_size);
+            // large_reserve внутри locked_alloc мог перестроить таблицу - старый entry недействителен
+            large_free(large_find(ptr));
+        }
+    }
+    pthread_mutex_unlock(&shim_mutex);
+
+    if (memory == NULL) {
+        errno = ENOMEM;
+    }
+    return memory;
+}
+
+void *reallocarray(void *ptr, size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return realloc(ptr, count * size);
+}
+
+size_t malloc_usable_size(void *ptr) {
+    if (ptr == NULL) {
+        return 0;
+    }
+    if (in_bootstrap(ptr)) {
+        return bootstrap_size(ptr);
+    }
+    if (__atomic_load_n(&state, __ATOMIC_ACQUIRE) == SHIM_FAILED && next_usable_size != NULL) {
+        return next_usable_size(ptr);
+    }
+
+    pthread_mutex_lock(&shim_mutex);
+    LargeEntry *entry = large_find(ptr);
+    size_t size = entry != NULL ? entry->size : backend_usable_size(allocator, ptr);
+    pthread_mutex_unlock(&shim_mutex);
+    return size;
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size) {
+    if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void *memory = shim_alloc(size, alignment);
+    if (memory == NULL) {
+        return ENOMEM;
+    }
+    *memptr = memory;
+    return 0;
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    void *memory = NULL;
+    int error = posix_memalign(&memory, alignment < sizeof(void *) ? sizeof(void *) : alignment, size);
+    if (error != 0) {
+        errno = error;
+        return NULL;
+    }
+    return memory;
+}
+
+void *memalign(size_t alignment, size_t size) {
+    return aligned_alloc(alignment, size);
+}
+
+void *valloc(size_t size) {
+    return aligned_alloc((size_t) sysconf(_SC_PAGESIZE), size);
+}
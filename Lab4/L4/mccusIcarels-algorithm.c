@@ -1,102 +1,337 @@
-#include "mccusIcarels-algorithm.h"
-
-Allocator *allocator_create(void *const memory, const size_t size) {
-    if (memory == NULL || size < PAGE_SIZE) {
-        return NULL;
-    }
-
-    Allocator *allocator = (Allocator *) memory;
-    allocator->memory = (uint8_t *) memory + sizeof(Allocator);
-    allocator->size = size - sizeof(Allocator);
-    allocator->free_pages = (Page *) allocator->memory;
-
-    size_t num_pages = allocator->size / PAGE_SIZE;
-    for (size_t i = 0; i < num_pages; i++) {
-        Page *page = (Page *) ((uint8_t *) allocator->memory + i * PAGE_SIZE);
-        page->page_size = PAGE_SIZE;
-        page->next_free = (i == num_pages - 1) ? NULL : (Page *) ((uint8_t *) allocator->memory + (i + 1) * PAGE_SIZE);
-        page->free_blocks = NULL;
-    }
-
-    return allocator;
-}
-
-
-void allocator_destroy(Allocator *const allocator) {
-    if (allocator == NULL) {
-        return;
-    }
-
-    munmap(allocator, allocator->size + sizeof(Allocator));
-}
-
-void *allocator_alloc(Allocator *const allocator, const size_t size) {
-    if (allocator == NULL || size == 0 || size > allocator->size) {
-        return NULL;
-    }
-
-    size_t block_size = 1;
-    while (block_size < size + sizeof(Block) && block_size < PAGE_SIZE) {
-        block_size *= 2;
-    }
-
-    Page *page = allocator->free_pages;
-    while (page != NULL) {
-        Block *block = page->free_blocks;
-        Block *prev = NULL;
-
-        while (block != NULL) {
-            if (block->block_size >= block_size && block->is_free) {
-                if (prev == NULL) {
-                    page->free_blocks = block->next_free;
-                } else {
-                    prev->next_free = block->next_free;
-                }
-                block->is_free = false;
-                return (void *) ((uint8_t *) block + sizeof(Block));
-            }
-            prev = block;
-            block = block->next_free;
-        }
-        page = page->next_free;
-    }
-
-    page = allocator->free_pages;
-    if (page == NULL) {
-        return NULL;
-    }
-    allocator->free_pages = page->next_free;
-
-    size_t num_blocks = PAGE_SIZE / block_size;
-    for (size_t i = 0; i < num_blocks; i++) {
-        Block *block = (Block *) ((uint8_t *) page + i * block_size);
-        block->block_size = block_size;
-        block->next_free = page->free_blocks;
-        block->is_free = true;
-        page->free_blocks = block;
-    }
-
-    Block *block = page->free_blocks;
-    page->free_blocks = block->next_free;
-    block->is_free = false;
-    return (void *) ((uint8_t *) block + sizeof(Block));
-}
-
-void allocator_free(Allocator *const allocator, void *const memory) {
-    if (allocator == NULL || memory == NULL) {
-        return;
-    }
-
-    Block *block = (Block *) ((uint8_t *) memory - sizeof(Block));
-
-    Page *page = allocator->free_pages;
-    while (page != NULL) {
-        if ((uint8_t *) block >= (uint8_t *) page && (uint8_t *) block < (uint8_t *) page + PAGE_SIZE) {
-            block->next_free = page->free_blocks;
-            block->is_free = true;
-            page->free_blocks = block;
-            return;
-        }
-        page = page->next_free;
-    }
+#include "mccusIcarels-algorithm.h"
+#include "../../Trace/trace.h"
+
+// Показатель ближайшей степени двойки, не меньшей block_size
+static size_t class_index(size_t block_size) {
+    if (block_size <= 1) {
+        return 0;
+    }
+    return (size_t) (64 - __builtin_clzll(block_size - 1));
+}
+
+static void push_pages(Allocator *const allocator, uint8_t *pages, size_t num_pages) {
+    for (size_t i = num_pages; i-- > 0;) {
+        Page *page = (Page *) (pages + i * PAGE_SIZE);
+        page->page_size = PAGE_SIZE;
+        page->next_free = allocator->free_pages;
+        allocator->free_pages = page;
+    }
+    allocator->free_page_count += num_pages;
+}
+
+// Возвращает в работу простаивающую область или отображает новую, вдвое больше предыдущей
+// (до REGION_GROW_LIMIT); если столько не отображается - область меньше, вплоть до одной страницы
+static bool allocator_grow(Allocator *const allocator) {
+    for (Region *region = allocator->regions; region != NULL; region = region->next) {
+        if (region->idle) {
+            region->idle = false;
+            push_pages(allocator, region->pages, region->num_pages);
+            return true;
+        }
+    }
+
+    size_t region_size = allocator->next_region_size;
+    Region *region = (Region *) region_map_fallback(&region_size, 2 * PAGE_SIZE);
+    if (region == NULL) {
+        return false;
+    }
+    region->size = region_size;
+    region->next = allocator->regions;
+    region->pages = (uint8_t *) region + PAGE_SIZE;
+    region->num_pages = region_size / PAGE_SIZE - 1;
+    region->used_blocks = 0;
+    region->idle = false;
+    allocator->regions = region;
+    allocator->region_count++;
+    allocator->next_region_size = region_next_size(region_size);
+
+    allocator->total_pages += region->num_pages;
+    push_pages(allocator, region->pages, region->num_pages);
+    return true;
+}
+
+static Region *find_region(Allocator *const allocator, void *const memory) {
+    for (Region *region = allocator->regions; region != NULL; region = region->next) {
+        if ((uint8_t *) memory >= region->pages && (uint8_t *) memory < (uint8_t *) region + region->size) {
+            return region;
+        }
+    }
+    return NULL;
+}
+
+// Область опустела: убираем её блоки и страницы из списков и отдаём память системе
+static void retire_region(Allocator *const allocator, Region *region) {
+    uint8_t *start = region->pages;
+    uint8_t *end = (uint8_t *) region + region->size;
+
+    for (size_t i = 0; i < PAGE_CLASSES; i++) {
+        Block **link = &allocator->class_free[i];
+        while (*link != NULL) {
+            if ((uint8_t *) *link >= start && (uint8_t *) *link < end) {
+                *link = (*link)->next_free;
+                allocator->class_free_count[i]--;
+            } else {
+                link = &(*link)->next_free;
+            }
+        }
+    }
+
+    Page **link = &allocator->free_pages;
+    while (*link != NULL) {
+        if ((uint8_t *) *link >= start && (uint8_t *) *link < end) {
+            *link = (*link)->next_free;
+            allocator->free_page_count--;
+        } else {
+            link = &(*link)->next_free;
+        }
+    }
+
+    region_release(start, end);
+    region->idle = true;
+}
+
+Allocator *allocator_create(void *const memory, const size_t size) {
+    if (memory == NULL || size < PAGE_SIZE) {
+        return NULL;
+    }
+
+    Allocator *allocator = (Allocator *) memory;
+    allocator->memory = (uint8_t *) memory + sizeof(Allocator);
+    allocator->size = size - sizeof(Allocator);
+    allocator->free_pages = (Page *) allocator->memory;
+    memset(allocator->class_free, 0, sizeof(allocator->class_free));
+    allocator->regions = NULL;
+    allocator->spare_region = NULL;
+    allocator->region_count = 0;
+    allocator->next_region_size = size;
+
+    size_t num_pages = allocator->size / PAGE_SIZE;
+    for (size_t i = 0; i < num_pages; i++) {
+        Page *page = (Page *) ((uint8_t *) allocator->memory + i * PAGE_SIZE);
+        page->page_size = PAGE_SIZE;
+        page->next_free = (i == num_pages - 1) ? NULL : (Page *) ((uint8_t *) allocator->memory + (i + 1) * PAGE_SIZE);
+    }
+
+    allocator->total_pages = num_pages;
+    allocator->free_page_count = num_pages;
+    allocator->used_bytes = 0;
+    allocator->alloc_count = 0;
+    allocator->free_count = 0;
+    allocator->failed_allocs = 0;
+    memset(allocator->class_free_count, 0, sizeof(allocator->class_free_count));
+    memset(allocator->class_used, 0, sizeof(allocator->class_used));
+
+    return allocator;
+}
+
+
+void allocator_destroy(Allocator *const allocator) {
+    if (allocator == NULL) {
+        return;
+    }
+
+    Region *region = allocator->regions;
+    while (region != NULL) {
+        Region *next = region->next;
+        munmap(region, region->size);
+        region = next;
+    }
+    munmap(allocator, allocator->size + sizeof(Allocator));
+}
+
+void *allocator_alloc(Allocator *const allocator, const size_t size) {
+    TRACE_SCOPE("allocator_alloc");
+    if (allocator == NULL) {
+        return NULL;
+    }
+    if (size == 0 || size > PAGE_SIZE - sizeof(Block)) {
+        allocator->failed_allocs++;
+        return NULL;
+    }
+
+    // size + sizeof(Block) не больше PAGE_SIZE, поэтому степень двойки помещается в страницу
+    size_t index = class_index(size + sizeof(Block));
+    size_t block_size = (size_t) 1 << index;
+
+    if (allocator->class_free[index] == NULL) {
+        // Блоков нужного класса нет - разрезаем новую страницу
+        if (allocator->free_pages == NULL && !allocator_grow(allocator)) {
+            allocator->failed_allocs++;
+            return NULL;
+        }
+        Page *page = allocator->free_pages;
+        allocator->free_pages = page->next_free;
+        allocator->free_page_count--;
+
+        size_t num_blocks = PAGE_SIZE / block_size;
+        for (size_t i = 0; i < num_blocks; i++) {
+            Block *block = (Block *) ((uint8_t *) page + i * block_size);
+            block->block_size = block_size;
+            block->next_free = allocator->class_free[index];
+            block->is_free = true;
+            allocator->class_free[index] = block;
+        }
+        allocator->class_free_count[index] += num_blocks;
+    }
+
+    Block *block = allocator->class_free[index];
+    allocator->class_free[index] = block->next_free;
+    block->is_free = false;
+
+    Region *region = find_region(allocator, block);
+    if (region != NULL && region->used_blocks++ == 0 && region == allocator->spare_region) {
+        allocator->spare_region = NULL;
+    }
+    allocator->class_free_count[index]--;
+    allocator->class_used[allocator_stats_class(block_size - sizeof(Block))]++;
+    allocator->used_bytes += block_size;
+    allocator->alloc_count++;
+    return (void *) ((uint8_t *) block + sizeof(Block));
+}
+
+// Перед выравненным адресом лежит заголовок с block_size == 0, ссылающийся на настоящий блок
+static Block *block_of(void *const memory) {
+    Block *block = (Block *) ((uint8_t *) memory - sizeof(Block));
+    if (block->block_size == 0) {
+        block = block->next_free;
+    }
+    return block;
+}
+
+void *allocator_alloc_aligned(Allocator *const allocator, const size_t size, const size_t alignment) {
+    if (allocator == NULL) {
+        return NULL;
+    }
+    if (size > PAGE_SIZE || alignment == 0 || (alignment & (alignment - 1)) != 0 || alignment > PAGE_SIZE / 2) {
+        allocator->failed_allocs++;
+        return NULL;
+    }
+    if (alignment <= sizeof(size_t)) {
+        return allocator_alloc(allocator, size);
+    }
+
+    uint8_t *memory = allocator_alloc(allocator, size + alignment - 1 + sizeof(Block));
+    if (memory == NULL) {
+        return NULL;
+    }
+    if ((uintptr_t) memory % alignment == 0) {
+        return memory;
+    }
+
+    uintptr_t aligned = ((uintptr_t) memory + sizeof(Block) + alignment - 1) & ~(alignment - 1);
+    Block *link = (Block *) (aligned - sizeof(Block));
+    link->block_size = 0;
+    link->next_free = (Block *) (memory - sizeof(Block));
+    link->is_free = false;
+    return (void *) aligned;
+}
+
+void *allocator_calloc(Allocator *const allocator, const size_t count, const size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        if (allocator != NULL) {
+            allocator->failed_allocs++;
+        }
+        return NULL;
+    }
+    void *memory = allocator_alloc(allocator, count * size);
+    if (memory != NULL) {
+        memset(memory, 0, count * size);
+    }
+    return memory;
+}
+
+// Блоки одного класса не соседствуют со свободным местом другого размера,
+// поэтому на месте realloc возможен только в пределах уже выделенного блока
+void *allocator_realloc(Allocator *const allocator, void *const memory, const size_t size) {
+    if (memory == NULL) {
+        return allocator_alloc(allocator, size);
+    }
+    if (allocator == NULL) {
+        return NULL;
+    }
+
+    size_t available = allocator_usable_size(allocator, memory);
+    if (size <= available) {
+        return memory;
+    }
+
+    void *moved = allocator_alloc(allocator, size);
+    if (moved == NULL) {
+        return NULL;
+    }
+    memcpy(moved, memory, available);
+    allocator_free(allocator, memory);
+    return moved;
+}
+
+size_t allocator_usable_size(Allocator *const allocator, void *const memory) {
+    (void) allocator;
+    if (memory == NULL) {
+        return 0;
+    }
+    Block *block = block_of(memory);
+    return block->block_size - (size_t) ((uint8_t *) memory - (uint8_t *) block);
+}
+
+void allocator_free(Allocator *const allocator, void *const memory) {
+    TRACE_SCOPE("allocator_free");
+    if (allocator == NULL || memory == NULL) {
+        return;
+    }
+
+    Block *block = block_of(memory);
+    if (block->is_free) {
+        return;
+    }
+
+    size_t index = class_index(block->block_size);
+    block->next_free = allocator->class_free[index];
+    block->is_free = true;
+    allocator->class_free[index] = block;
+
+    allocator->class_free_count[index]++;
+    allocator->class_used[allocator_stats_class(block->block_size - sizeof(Block))]--;
+    allocator->used_bytes -= block->block_size;
+    allocator->free_count++;
+
+    // Одна опустевшая область остаётся в работе: иначе alloc/free на границе области
+    // на каждом круге платили бы за madvise, проход по спискам и повторный рост.
+    // Отдаётся системе предыдущая опустевшая, а только что освободившаяся ждёт
+    Region *region = find_region(allocator, block);
+    if (region != NULL && --region->used_blocks == 0) {
+        if (allocator->spare_region != NULL && allocator->spare_region != region) {
+            retire_region(allocator, allocator->spare_region);
+        }
+        allocator->spare_region = region;
+    }
+}
+
+void allocator_stats(Allocator *const allocator, AllocatorStats *const stats) {
+    if (allocator == NULL || stats == NULL) {
+        return;
+    }
+
+    stats->total_bytes = allocator->total_pages * PAGE_SIZE;
+    stats->region_count = allocator->region_count;
+    stats->used_bytes = allocator->used_bytes;
+    stats->free_bytes = stats->total_bytes - stats->used_bytes;
+
+    // Наибольший свободный блок - целая страница, иначе старший непустой класс;
+    // размер известен точно: блок класса i без заголовка
+    stats->largest_free_block = 0;
+    if (allocator->free_page_count > 0) {
+        stats->largest_free_block = PAGE_SIZE - sizeof(Block);
+    } else {
+        for (size_t i = PAGE_CLASSES; i-- > 0;) {
+            if (allocator->class_free_count[i] > 0) {
+                stats->largest_free_block = ((size_t) 1 << i) - sizeof(Block);
+                break;
+            }
+        }
+    }
+
+    stats->alloc_count = allocator->alloc_count;
+    stats->free_count = allocator->free_count;
+    stats->failed_allocs = allocator->failed_allocs;
+    memcpy(stats->class_used, allocator->class_used, sizeof(stats->class_used));
 }
\ No newline at end of file
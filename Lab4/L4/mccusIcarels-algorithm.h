@@ -1,37 +1,76 @@
-#pragma once
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <stdint.h>
-#include <stdbool.h>
-#include <string.h>
-#include <sys/mman.h>
-
-#define PAGE_SIZE 4096
-
-typedef struct Block {
-    size_t block_size;
-    struct Block *next_free;
-    bool is_free;
-} Block;
-
-typedef struct Page {
-    size_t page_size;
-    struct Page *next_free;
-    Block *free_blocks;
-} Page;
-
-typedef struct Allocator {
-    void *memory;
-    size_t size;
-    Page *free_pages;
-} Allocator;
-
-
-Allocator *allocator_create(void *const memory, const size_t size);
-
-void *allocator_alloc(Allocator *const allocator, const size_t size);
-
-void allocator_free(Allocator *const allocator, void *const memory);
-
-void allocator_destroy(Allocator *const allocator);
\ No newline at end of file
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "allocator-stats.h"
+#include "region.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CLASSES 13
+
+typedef struct Block {
+    size_t block_size;
+    struct Block *next_free;
+    bool is_free;
+} Block;
+
+typedef struct Page {
+    size_t page_size;
+    struct Page *next_free;
+} Page;
+
+// Дополнительная область: заголовок занимает первую страницу, дальше страницы аллокатора
+typedef struct Region {
+    size_t size;
+    struct Region *next;
+    uint8_t *pages;
+    size_t num_pages;
+    size_t used_blocks;
+    bool idle;
+} Region;
+
+typedef struct Allocator {
+    void *memory;
+    size_t size;
+    Page *free_pages;
+    // Свободные блоки по классам: class_free[i] - блоки размера 2^i
+    Block *class_free[PAGE_CLASSES];
+
+    Region *regions;
+    Region *spare_region;  // Опустевшая, но ещё не отданная системе область
+    size_t region_count;
+    size_t next_region_size;
+
+    size_t total_pages;
+    size_t free_page_count;
+    size_t used_bytes;
+    size_t alloc_count;
+    size_t free_count;
+    size_t failed_allocs;
+    size_t class_free_count[PAGE_CLASSES];
+    size_t class_used[ALLOCATOR_STATS_CLASSES];  // По полезному размеру блока, как в allocator-stats.h
+} Allocator;
+
+
+Allocator *allocator_create(void *const memory, const size_t size);
+
+void *allocator_alloc(Allocator *const allocator, const size_t size);
+
+void *allocator_alloc_aligned(Allocator *const allocator, const size_t size, const size_t alignment);
+
+void *allocator_realloc(Allocator *const allocator, void *const memory, const size_t size);
+
+void *allocator_calloc(Allocator *const allocator, const size_t count, const size_t size);
+
+size_t allocator_usable_size(Allocator *const allocator, void *const memory);
+
+void allocator_free(Allocator *const allocator, void *const memory);
+
+void allocator_destroy(Allocator *const allocator);
+
+void allocator_stats(Allocator *const allocator, AllocatorStats *const stats);
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Дополнительные области памяти, которые аллокаторы отображают по мере роста.
+// Сборка с -DALLOCATOR_HUGETLB включает попытку MAP_HUGETLB для больших областей.
+
+#define REGION_HUGE_PAGE (2 * 1024 * 1024)
+#define REGION_MAX_SIZE ((size_t) 1 << 40)
+#define REGION_GROW_LIMIT ((size_t) 64 * 1024 * 1024)  // Предел удвоения следующей области
+
+static inline size_t region_round(size_t size) {
+    size_t align = size >= REGION_HUGE_PAGE ? REGION_HUGE_PAGE : (size_t) sysconf(_SC_PAGESIZE);
+    return (size + align - 1) & ~(align - 1);
+}
+
+static inline void *region_map(size_t size) {
+    if (size == 0 || size > REGION_MAX_SIZE) {
+        return NULL;
+    }
+
+    void *memory = MAP_FAILED;
+#if defined(ALLOCATOR_HUGETLB) && defined(MAP_HUGETLB)
+    if (size % REGION_HUGE_PAGE == 0) {
+        memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if (memory == MAP_FAILED) {
+        memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (memory == MAP_FAILED) {
+        return NULL;
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (size >= REGION_HUGE_PAGE) {
+        madvise(memory, size, MADV_HUGEPAGE);
+    }
+#endif
+    return memory;
+}
+
+// Отображает область размера *size, а если mmap отказал - вдвое меньшую, но не меньше min_size.
+// В *size записывается размер, который удалось отобразить
+static inline void *region_map_fallback(size_t *size, size_t min_size) {
+    min_size = region_round(min_size);
+    size_t region_size = region_round(*size < min_size ? min_size : *size);
+    while (1) {
+        void *memory = region_map(region_size);
+        if (memory != NULL) {
+            *size = region_size;
+            return memory;
+        }
+        if (region_size <= min_size) {
+            return NULL;
+        }
+        region_size = region_round(region_size / 2 < min_size ? min_size : region_size / 2);
+    }
+}
+
+static inline size_t region_next_size(size_t size) {
+    return size < REGION_GROW_LIMIT / 2 ? size * 2 : REGION_GROW_LIMIT;
+}
+
+// Отдаёт системе целые страницы внутри [start, end), память остаётся отображённой
+static inline void region_release(void *start, void *end) {
+    uintptr_t page = (uintptr_t) sysconf(_SC_PAGESIZE);
+    uintptr_t from = ((uintptr_t) start + page - 1) & ~(page - 1);
+    uintptr_t to = (uintptr_t) end & ~(page - 1);
+    if (from < to) {
+        madvise((void *) from, to - from, MADV_DONTNEED);
+    }
+}
@@ -0,0 +1,345 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "shm-allocator.h"
+
+#define SHM_ARENA_MAGIC 0x41524853u  // "SHRA"
+#define SHM_ARENA_VERSION 1
+#define SHM_BLOCK_USED ((uint64_t) 1)
+#define SHM_MIN_SPLIT (sizeof(ShmBlock) + SHM_ALLOCATOR_ALIGNMENT)
+
+// Длины отображений shm_arena_open в этом процессе. В заголовке сегмента их хранить нельзя:
+// он общий, а каждый процесс отображает сегмент своей длины (arena->size к тому же округлён вниз)
+typedef struct ShmMapping {
+    ShmArena *arena;
+    size_t length;
+    struct ShmMapping *next;
+} ShmMapping;
+
+static ShmMapping *shm_mappings = NULL;
+static pthread_mutex_t shm_mappings_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static ShmBlock *block_at(ShmArena *arena, ShmOffset offset) {
+    return (ShmBlock *) ((char *) arena + offset);
+}
+
+static uint64_t block_size(const ShmBlock *block) {
+    return block->size & ~SHM_BLOCK_USED;
+}
+
+// Смещение блока сразу за block
+static ShmOffset block_end(ShmOffset offset, const ShmBlock *block) {
+    return offset + sizeof(ShmBlock) + block_size(block);
+}
+
+// Владелец мьютекса умер посреди операции: список свободных блоков и счётчики
+// восстанавливаются по заголовкам, которые лежат в сегменте подряд
+static void arena_recover(ShmArena *arena) {
+    ShmOffset tail = SHM_NULL;
+    arena->free_list = SHM_NULL;
+    arena->used_bytes = 0;
+    arena->free_bytes = 0;
+    memset(arena->class_used, 0, sizeof(arena->class_used));
+
+    ShmOffset offset = arena->heap;
+    while (offset + sizeof(ShmBlock) <= arena->size) {
+        ShmBlock *block = block_at(arena, offset);
+        ShmOffset next = block_end(offset, block);
+        if (next > arena->size) {
+            break;
+        }
+
+        if (block->size & SHM_BLOCK_USED) {
+            arena->used_bytes += block_size(block);
+            arena->class_used[allocator_stats_class(block_size(block))]++;
+        } else if (tail != SHM_NULL && block_end(tail, block_at(arena, tail)) == offset) {
+            // Два свободных блока подряд - недоделанное слияние
+            block_at(arena, tail)->size += sizeof(ShmBlock) + block->size;
+            arena->free_bytes += sizeof(ShmBlock) + block->size;
+        } else {
+            block->next = SHM_NULL;
+            if (tail == SHM_NULL) {
+                arena->free_list = offset;
+            } else {
+                block_at(arena, tail)->next = offset;
+            }
+            tail = offset;
+            arena->free_bytes += block->size;
+        }
+        offset = next;
+    }
+    arena->recoveries++;
+}
+
+static int arena_lock(ShmArena *arena) {
+    int result = pthread_mutex_lock(&arena->lock);
+    if (result == EOWNERDEAD) {
+        arena_recover(arena);
+        pthread_mutex_consistent(&arena->lock);
+        return 0;
+    }
+    return result;
+}
+
+static void arena_unlock(ShmArena *arena) {
+    pthread_mutex_unlock(&arena->lock);
+}
+
+ShmArena *shm_arena_create(void *memory, size_t size) {
+    size_t heap = align_up(sizeof(ShmArena), SHM_ALLOCATOR_ALIGNMENT);
+    if (memory == NULL || size < heap + SHM_MIN_SPLIT) {
+        return NULL;
+    }
+
+    ShmArena *arena = (ShmArena *) memory;
+    memset(arena, 0, sizeof(ShmArena));
+
+    pthread_mutexattr_t attributes;
+    if (pthread_mutexattr_init(&attributes) != 0) {
+        return NULL;
+    }
+    pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+    int result = pthread_mutex_init(&arena->lock, &attributes);
+    pthread_mutexattr_destroy(&attributes);
+    if (result != 0) {
+        return NULL;
+    }
+
+    arena->size = size & ~(uint64_t) (SHM_ALLOCATOR_ALIGNMENT - 1);
+    arena->heap = heap;
+    arena->free_list = heap;
+
+    ShmBlock *block = block_at(arena, heap);
+    block->size = arena->size - heap - sizeof(ShmBlock);
+    block->next = SHM_NULL;
+    arena->free_bytes = block->size;
+
+    // Признак готовности пишется последним: attach не увидит наполовину размеченный сегмент
+    arena->version = SHM_ARENA_VERSION;
+    __atomic_store_n(&arena->magic, SHM_ARENA_MAGIC, __ATOMIC_RELEASE);
+    return arena;
+}
+
+ShmArena *shm_arena_attach(void *memory, size_t size) {
+    ShmArena *arena = (ShmArena *) memory;
+    if (memory == NULL || size < sizeof(ShmArena) ||
+        __atomic_load_n(&arena->magic, __ATOMIC_ACQUIRE) != SHM_ARENA_MAGIC ||
+        arena->version != SHM_ARENA_VERSION || arena->size > size) {
+        return NULL;
+    }
+    return arena;
+}
+
+ShmArena *shm_arena_open(const char *name, size_t size, int create) {
+    int is_shm = name[0] == '/' && strchr(name + 1, '/') == NULL;
+    int flags = O_RDWR | (create ? O_CREAT | O_TRUNC : 0);
+    int fd = is_shm ? shm_open(name, flags, 0644) : open(name, flags, 0644);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    if (create) {
+        if (ftruncate(fd, size) == -1) {
+            close(fd);
+            return NULL;
+        }
+    } else if (size == 0) {
+        struct stat info;
+        if (fstat(fd, &info) == -1) {
+            close(fd);
+            return NULL;
+        }
+        size = info.st_size;
+    }
+
+    void *memory = size ? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (memory == MAP_FAILED) {
+        return NULL;
+    }
+
+    ShmArena *arena = create ? shm_arena_create(memory, size) : shm_arena_attach(memory, size);
+    ShmMapping *mapping = arena != NULL ? malloc(sizeof(ShmMapping)) : NULL;
+    if (mapping == NULL) {
+        munmap(memory, size);
+        return NULL;
+    }
+    mapping->arena = arena;
+    mapping->length = size;
+    pthread_mutex_lock(&shm_mappings_lock);
+    mapping->next = shm_mappings;
+    shm_mappings = mapping;
+    pthread_mutex_unlock(&shm_mappings_lock);
+    return arena;
+}
+
+void shm_arena_close(ShmArena *arena) {
+    if (arena == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&shm_mappings_lock);
+    ShmMapping **link = &shm_mappings;
+    while (*link != NULL && (*link)->arena != arena) {
+        link = &(*link)->next;
+    }
+    ShmMapping *mapping = *link;
+    if (mapping != NULL) {
+        *link = mapping->next;
+    }
+    pthread_mutex_unlock(&shm_mappings_lock);
+
+    // Сегмент не из shm_arena_open отображал вызывающий - его длину знает только он
+    if (mapping != NULL) {
+        munmap(arena, mapping->length);
+        free(mapping);
+    }
+}
+
+ShmOffset shm_alloc(ShmArena *arena, size_t size) {
+    if (size > arena->size) {
+        __atomic_add_fetch(&arena->failed_allocs, 1, __ATOMIC_RELAXED);
+        return SHM_NULL;
+    }
+    size = align_up(size ? size : 1, SHM_ALLOCATOR_ALIGNMENT);
+    if (arena_lock(arena) != 0) {
+        return SHM_NULL;
+    }
+
+    ShmOffset prev = SHM_NULL;
+    ShmOffset offset = arena->free_list;
+    while (offset != SHM_NULL && block_at(arena, offset)->size < size) {
+        prev = offset;
+        offset = block_at(arena, offset)->next;
+    }
+    if (offset == SHM_NULL) {
+        arena->failed_allocs++;
+        arena_unlock(arena);
+        return SHM_NULL;
+    }
+
+    ShmBlock *block = block_at(arena, offset);
+    ShmOffset replacement = block->next;
+    if (block->size >= size + SHM_MIN_SPLIT) {
+        // Хвост размечается до того, как блок уменьшится: обход сегмента не увидит пустоты
+        ShmOffset tail_offset = offset + sizeof(ShmBlock) + size;
+        ShmBlock *tail = block_at(arena, tail_offset);
+        tail->size = block->size - size - sizeof(ShmBlock);
+        tail->next = block->next;
+        block->size = size;
+        replacement = tail_offset;
+        arena->free_bytes -= sizeof(ShmBlock);
+    }
+
+    if (prev == SHM_NULL) {
+        arena->free_list = replacement;
+    } else {
+        block_at(arena, prev)->next = replacement;
+    }
+    block->next = SHM_NULL;
+    block->size |= SHM_BLOCK_USED;
+
+    arena->free_bytes -= block_size(block);
+    arena->used_bytes += block_size(block);
+    arena->alloc_count++;
+    arena->class_used[allocator_stats_class(block_size(block))]++;
+    arena_unlock(arena);
+    return offset + sizeof(ShmBlock);
+}
+
+// Смещение заголовка или SHM_NULL, если offset не похож на выданный shm_alloc
+static ShmOffset block_of(ShmArena *arena, ShmOffset offset) {
+    if (offset < arena->heap + sizeof(ShmBlock) || offset >= arena->size ||
+        offset % SHM_ALLOCATOR_ALIGNMENT != 0) {
+        return SHM_NULL;
+    }
+    return offset - sizeof(ShmBlock);
+}
+
+void shm_free(ShmArena *arena, ShmOffset offset) {
+    ShmOffset block_offset = block_of(arena, offset);
+    if (block_offset == SHM_NULL || arena_lock(arena) != 0) {
+        return;
+    }
+
+    ShmBlock *block = block_at(arena, block_offset);
+    if (!(block->size & SHM_BLOCK_USED)) {
+        arena_unlock(arena);  // Повторное освобождение
+        return;
+    }
+
+    uint64_t size = block_size(block);
+    arena->used_bytes -= size;
+    arena->free_bytes += size;
+    arena->free_count++;
+    arena->class_used[allocator_stats_class(size)]--;
+
+    // Соседи по упорядоченному списку
+    ShmOffset prev = SHM_NULL;
+    ShmOffset next = arena->free_list;
+    while (next != SHM_NULL && next < block_offset) {
+        prev = next;
+        next = block_at(arena, next)->next;
+    }
+
+    block->next = next;
+    block->size = size;
+    if (next != SHM_NULL && block_end(block_offset, block) == next) {
+        ShmBlock *next_block = block_at(arena, next);
+        block->next = next_block->next;
+        block->size += sizeof(ShmBlock) + next_block->size;
+        arena->free_bytes += sizeof(ShmBlock);
+    }
+
+    if (prev != SHM_NULL && block_end(prev, block_at(arena, prev)) == block_offset) {
+        ShmBlock *prev_block = block_at(arena, prev);
+        prev_block->next = block->next;
+        prev_block->size += sizeof(ShmBlock) + block->size;
+        arena->free_bytes += sizeof(ShmBlock);
+    } else if (prev != SHM_NULL) {
+        block_at(arena, prev)->next = block_offset;
+    } else {
+        arena->free_list = block_offset;
+    }
+    arena_unlock(arena);
+}
+
+size_t shm_usable_size(ShmArena *arena, ShmOffset offset) {
+    ShmOffset block_offset = block_of(arena, offset);
+    return block_offset == SHM_NULL ? 0 : block_size(block_at(arena, block_offset));
+}
+
+void shm_arena_stats(ShmArena *arena, AllocatorStats *stats) {
+    if (arena_lock(arena) != 0) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    stats->total_bytes = arena->size - arena->heap;
+    stats->region_count = 1;
+    stats->used_bytes = arena->used_bytes;
+    stats->free_bytes = arena->free_bytes;
+    stats->largest_free_block = 0;
+    for (ShmOffset offset = arena->free_list; offset != SHM_NULL; offset = block_at(arena, offset)->next) {
+        if (block_at(arena, offset)->size > stats->largest_free_block) {
+            stats->largest_free_block = block_at(arena, offset)->size;
+        }
+    }
+    stats->alloc_count = arena->alloc_count;
+    stats->free_count = arena->free_count;
+    stats->failed_allocs = arena->failed_allocs;
+    for (size_t i = 0; i < ALLOCATOR_STATS_CLASSES; i++) {
+        stats->class_used[i] = arena->class_used[i];
+    }
+    arena_unlock(arena);
+}
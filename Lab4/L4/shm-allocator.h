@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "allocator-stats.h"
+
+// Аллокатор внутри разделяемого отображения (shm_open или файл), которым пользуются несколько процессов.
+// Процессы могут отобразить сегмент по разным адресам, поэтому внутри хранятся только смещения
+// от начала сегмента, а наружу вместо указателей отдаётся ShmOffset - его можно передать
+// другому процессу восемью байтами (через канал, сокет или саму общую память).
+//
+// Список свободных блоков упорядочен по смещению, соседние свободные блоки сливаются при free.
+// Все операции идут под мьютексом PTHREAD_PROCESS_SHARED | PTHREAD_MUTEX_ROBUST: если процесс
+// умер, держа его, следующий владелец заново строит список свободных блоков обходом сегмента.
+// Заголовки пишутся в таком порядке, что обход всегда видит либо состояние до операции, либо после.
+
+#define SHM_ALLOCATOR_ALIGNMENT 16
+#define SHM_NULL ((ShmOffset) 0)
+
+typedef uint64_t ShmOffset;
+
+typedef struct ShmBlock {
+    uint64_t size;  // Размер данных; младший бит - блок занят
+    ShmOffset next;  // Следующий свободный блок
+} ShmBlock;
+
+typedef struct ShmArena {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t size;
+    ShmOffset heap;  // Первый блок
+    ShmOffset free_list;
+    pthread_mutex_t lock;
+
+    uint64_t used_bytes;
+    uint64_t free_bytes;
+    uint64_t alloc_count;
+    uint64_t free_count;
+    uint64_t failed_allocs;
+    uint64_t recoveries;  // Сколько раз чинили сегмент после смерти владельца мьютекса
+    uint64_t class_used[ALLOCATOR_STATS_CLASSES];
+} ShmArena;
+
+// Размечает свежий сегмент memory размером size
+ShmArena *shm_arena_create(void *memory, size_t size);
+
+// Проверяет уже размеченный другим процессом сегмент
+ShmArena *shm_arena_attach(void *memory, size_t size);
+
+// Отображает объект shm_open (name вида "/имя") или файл (любой другой путь);
+// create - создать и разметить заново.
+// Без create size может быть 0 - тогда берётся размер объекта
+ShmArena *shm_arena_open(const char *name, size_t size, int create);
+
+// Снимает отображение shm_arena_open целиком, той длины, с которой оно было создано в этом процессе.
+// Сегменты, размеченные shm_arena_create/attach поверх своей памяти, вызывающий освобождает сам
+void shm_arena_close(ShmArena *arena);
+
+// SHM_NULL, если места нет
+ShmOffset shm_alloc(ShmArena *arena, size_t size);
+
+void shm_free(ShmArena *arena, ShmOffset offset);
+
+size_t shm_usable_size(ShmArena *arena, ShmOffset offset);
+
+void shm_arena_stats(ShmArena *arena, AllocatorStats *stats);
+
+static inline void *shm_ptr(ShmArena *arena, ShmOffset offset) {
+    return offset == SHM_NULL ? NULL : (char *) arena + offset;
+}
+
+static inline ShmOffset shm_offset_of(ShmArena *arena, const void *ptr) {
+    return ptr == NULL ? SHM_NULL : (ShmOffset) ((const char *) ptr - (const char *) arena);
+}
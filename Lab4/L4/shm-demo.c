@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "shm-allocator.h"
+
+// Сборка: gcc -O2 -o shm-demo shm-demo.c shm-allocator.c -pthread
+//
+// ./shm-demo <children> <messages_per_child> [segment_size]
+//
+// Вместо фиксированного массива из Lab3 дети выделяют сообщения переменной длины прямо
+// в общем сегменте и передают родителю по каналу только 8-байтовое смещение.
+// Каждый ребёнок заново отображает сегмент по своему адресу, поэтому указатели между
+// процессами не совпадают, а смещения работают. Родитель проверяет сообщение на месте и освобождает его.
+
+#define SHM_NAME "/lab4_shm_arena"
+#define DEFAULT_SEGMENT_SIZE (1 << 20)
+#define MAX_PAYLOAD 4096
+
+typedef struct Message {
+    uint32_t child;
+    uint32_t sequence;
+    uint32_t length;
+    uint32_t checksum;
+    unsigned char payload[];
+} Message;
+
+static uint32_t checksum(const unsigned char *data, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void write_all(int fd, const void *data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written == -1 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            perror("write");
+            _exit(EXIT_FAILURE);
+        }
+        data = (const char *) data + written;
+        size -= written;
+    }
+}
+
+static void run_child(int id, long messages, int channel, ShmArena *inherited, size_t segment_size) {
+    // Своё отображение того же объекта, пока унаследованное ещё занимает свой адрес - адреса разойдутся
+    ShmArena *arena = shm_arena_open(SHM_NAME, 0, 0);
+    if (arena == NULL) {
+        perror("shm_arena_open");
+        _exit(EXIT_FAILURE);
+    }
+    munmap(inherited, segment_size);
+    if (id == 0) {
+        printf("[Child 0] Сегмент отображён по %p, у родителя по %p\n", (void *) arena, (void *) inherited);
+        fflush(stdout);
+    }
+
+    srand(id + 1);
+    for (long sequence = 0; sequence < messages; sequence++) {
+        uint32_t length = 1 + rand() % MAX_PAYLOAD;
+        ShmOffset offset;
+        // Сегмент полон - ждём, пока родитель освободит прочитанное
+        while ((offset = shm_alloc(arena, sizeof(Message) + length)) == SHM_NULL) {
+            sched_yield();
+        }
+
+        Message *message = shm_ptr(arena, offset);
+        message->child = id;
+        message->sequence = sequence;
+        message->length = length;
+        for (uint32_t i = 0; i < length; i++) {
+            message->payload[i] = (unsigned char) (rand() & 0xff);
+        }
+        message->checksum = checksum(message->payload, length);
+
+        write_all(channel, &offset, sizeof(offset));  // 8 байт меньше PIPE_BUF - запись атомарна
+    }
+
+    shm_arena_close(arena);
+    _exit(EXIT_SUCCESS);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: ./shm-demo <children> <messages_per_child> [segment_size]\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int children = atoi(argv[1]);
+    long messages = atol(argv[2]);
+    size_t segment_size = argc > 3 ? strtoull(argv[3], NULL, 10) : DEFAULT_SEGMENT_SIZE;
+    if (children <= 0 || messages <= 0) {
+        fprintf(stderr, "Число детей и сообщений должно быть положительным.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    ShmArena *arena = shm_arena_open(SHM_NAME, segment_size, 1);
+    if (arena == NULL) {
+        perror("shm_arena_open");
+        exit(EXIT_FAILURE);
+    }
+
+    int channel[2];
+    if (pipe(channel) == -1) {
+        perror("pipe");
+        shm_unlink(SHM_NAME);
+        exit(EXIT_FAILURE);
+    }
+
+    for (int id = 0; id < children; id++) {
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork");
+            shm_unlink(SHM_NAME);
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            close(channel[0]);
+            run_child(id, messages, channel[1], arena, segment_size);
+        }
+    }
+    close(channel[1]);
+
+    long received = 0, corrupted = 0;
+    size_t bytes = 0;
+    ShmOffset offset;
+    ssize_t bytes_read;
+    while ((bytes_read = read(channel[0], &offset, sizeof(offset))) == sizeof(offset)) {
+        Message *message = shm_ptr(arena, offset);
+        if (message->length > MAX_PAYLOAD || checksum(message->payload, message->length) != message->checksum) {
+            corrupted++;
+        }
+        bytes += message->length;
+        received++;
+        shm_free(arena, offset);
+    }
+
+    int failed_children = 0;
+    for (int id = 0; id < children; id++) {
+        int status;
+        wait(&status);
+        failed_children += !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+
+    AllocatorStats stats;
+    shm_arena_stats(arena, &stats);
+    printf("Получено сообщений: %ld из %ld, байт: %zu, повреждено: %ld\n", received, children * messages, bytes,
+           corrupted);
+    printf("Выделений: %zu, освобождений: %zu, отказов (сегмент полон): %zu, занято после: %zu байт\n",
+           stats.alloc_count, stats.free_count, stats.failed_allocs, stats.used_bytes);
+
+    close(channel[0]);
+    shm_arena_close(arena);
+    shm_unlink(SHM_NAME);
+    return corrupted == 0 && failed_children == 0 && received == children * messages ? 0 : EXIT_FAILURE;
+}
@@ -0,0 +1,354 @@
+#include "slab-allocator.h"
+#include "../../Trace/trace.h"
+
+static size_t class_size(size_t index) {
+    return (size_t) SLAB_MIN_OBJECT << index;
+}
+
+static size_t class_capacity(size_t index) {
+    return SLAB_SIZE / class_size(index);
+}
+
+static size_t class_of(size_t size) {
+    if (size <= SLAB_MIN_OBJECT) {
+        return 0;
+    }
+    return (size_t) (64 - __builtin_clzll(size - 1)) - 3;
+}
+
+static SlabArena *arena_of_id(Allocator *const allocator, uint32_t id) {
+    for (size_t i = 0; i < allocator->arena_count; i++) {
+        SlabArena *arena = &allocator->arenas[i];
+        if (id >= arena->first_id && id < arena->first_id + arena->num_slabs) {
+            return arena;
+        }
+    }
+    return NULL;
+}
+
+static SlabArena *arena_of_address(Allocator *const allocator, void *const memory) {
+    for (size_t i = 0; i < allocator->arena_count; i++) {
+        SlabArena *arena = &allocator->arenas[i];
+        if ((uint8_t *) memory >= arena->base && (uint8_t *) memory < arena->base + arena->num_slabs * SLAB_SIZE) {
+            return arena;
+        }
+    }
+    return NULL;
+}
+
+static Slab *slab_of_id(Allocator *const allocator, uint32_t id) {
+    SlabArena *arena = arena_of_id(allocator, id);
+    return &arena->slabs[id - arena->first_id];
+}
+
+static void partial_push(Allocator *const allocator, uint32_t id) {
+    Slab *slab = slab_of_id(allocator, id);
+    slab->prev = SLAB_NONE;
+    slab->next = allocator->partial[slab->kind];
+    if (slab->next != SLAB_NONE) {
+        slab_of_id(allocator, slab->next)->prev = id;
+    }
+    allocator->partial[slab->kind] = id;
+}
+
+static void partial_remove(Allocator *const allocator, uint32_t id) {
+    Slab *slab = slab_of_id(allocator, id);
+    if (slab->prev != SLAB_NONE) {
+        slab_of_id(allocator, slab->prev)->next = slab->next;
+    } else {
+        allocator->partial[slab->kind] = slab->next;
+    }
+    if (slab->next != SLAB_NONE) {
+        slab_of_id(allocator, slab->next)->prev = slab->prev;
+    }
+}
+
+static void mark_run(SlabArena *arena, size_t first, size_t count, bool occupied) {
+    for (size_t i = first; i < first + count; i++) {
+        if (occupied) {
+            arena->occupied[i / 64] |= (uint64_t) 1 << (i % 64);
+        } else {
+            arena->occupied[i / 64] &= ~((uint64_t) 1 << (i % 64));
+        }
+    }
+}
+
+// Ищет count свободных слэбов подряд; полностью занятые слова пропускаются целиком
+static size_t find_run(SlabArena *arena, size_t count) {
+    size_t run_start = 0;
+    size_t run_length = 0;
+    size_t i = 0;
+    while (i < arena->num_slabs) {
+        uint64_t word = arena->occupied[i / 64];
+        if (i % 64 == 0 && word == UINT64_MAX) {
+            run_length = 0;
+            i += 64;
+            continue;
+        }
+        if (i % 64 == 0 && run_length == 0 && word != 0) {
+            // Сразу к первому свободному слэбу в слове
+            i += (size_t) __builtin_ctzll(~word);
+            if (i >= arena->num_slabs) {
+                break;
+            }
+        }
+        if (word & ((uint64_t) 1 << (i % 64))) {
+            run_length = 0;
+        } else {
+            if (run_length == 0) {
+                run_start = i;
+            }
+            if (++run_length == count) {
+                return run_start;
+            }
+        }
+        i++;
+    }
+    return SLAB_NONE;
+}
+
+// Размечает участок: [описатели слэбов][битовая карта занятости][выравнивание][слэбы]
+static bool arena_init(Allocator *const allocator, void *const memory, const size_t size) {
+    if (allocator->arena_count == SLAB_MAX_ARENAS || size < 2 * SLAB_SIZE) {
+        return false;
+    }
+
+    SlabArena *arena = &allocator->arenas[allocator->arena_count];
+    size_t num_slabs = (size - SLAB_SIZE) / (SLAB_SIZE + sizeof(Slab) + sizeof(uint64_t));
+    arena->slabs = (Slab *) memory;
+    arena->occupied = (uint64_t *) (arena->slabs + num_slabs);
+
+    uintptr_t metadata_end = (uintptr_t) (arena->occupied + (num_slabs + 63) / 64);
+    arena->base = (uint8_t *) ((metadata_end + SLAB_SIZE - 1) & ~(uintptr_t) (SLAB_SIZE - 1));
+    while (num_slabs > 0 && arena->base + num_slabs * SLAB_SIZE > (uint8_t *) memory + size) {
+        num_slabs--;
+    }
+    if (num_slabs == 0) {
+        return false;
+    }
+    arena->num_slabs = num_slabs;
+    arena->first_id = 0;
+    if (allocator->arena_count > 0) {
+        SlabArena *last = &allocator->arenas[allocator->arena_count - 1];
+        arena->first_id = last->first_id + (uint32_t) last->num_slabs;
+    }
+    arena->mapped_size = 0;
+
+    memset(arena->occupied, 0, (num_slabs + 63) / 64 * sizeof(uint64_t));
+    // Хвост последнего слова помечаем занятым, чтобы поиск не вышел за num_slabs
+    for (size_t i = num_slabs; i % 64 != 0; i++) {
+        arena->occupied[i / 64] |= (uint64_t) 1 << (i % 64);
+    }
+    for (size_t i = 0; i < num_slabs; i++) {
+        arena->slabs[i].kind = SLAB_EMPTY;
+    }
+
+    allocator->arena_count++;
+    return true;
+}
+
+// Отображает новый участок, вдвое больше предыдущего (до REGION_GROW_LIMIT), но не меньше нужного
+// под count слэбов; если столько не отображается - участок меньше, но вмещающий count слэбов
+static SlabArena *allocator_grow(Allocator *const allocator, size_t count) {
+    size_t needed = (count + 1) * (SLAB_SIZE + sizeof(Slab) + sizeof(uint64_t)) + SLAB_SIZE;
+    size_t arena_size = allocator->next_arena_size;
+
+    void *memory = region_map_fallback(&arena_size, needed);
+    if (memory == NULL) {
+        return NULL;
+    }
+    if (!arena_init(allocator, memory, arena_size)) {
+        munmap(memory, arena_size);
+        return NULL;
+    }
+    allocator->next_arena_size = region_next_size(arena_size);
+
+    SlabArena *arena = &allocator->arenas[allocator->arena_count - 1];
+    arena->mapped_size = arena_size;
+    return arena;
+}
+
+// Находит count свободных слэбов подряд в любом участке, при необходимости отображая новый
+static uint32_t take_run(Allocator *const allocator, size_t count) {
+    SlabArena *arena = NULL;
+    size_t first = SLAB_NONE;
+    for (size_t i = 0; i < allocator->arena_count && first == SLAB_NONE; i++) {
+        arena = &allocator->arenas[i];
+        first = find_run(arena, count);
+    }
+    if (first == SLAB_NONE) {
+        arena = allocator_grow(allocator, count);
+        if (arena == NULL) {
+            return SLAB_NONE;
+        }
+        first = find_run(arena, count);
+        if (first == SLAB_NONE) {
+            return SLAB_NONE;
+        }
+    }
+
+    mark_run(arena, first, count, true);
+    return arena->first_id + (uint32_t) first;
+}
+
+Allocator *allocator_create(void *const memory, const size_t size) {
+    if (memory == NULL || size < sizeof(Allocator) + 2 * SLAB_SIZE) {
+        return NULL;
+    }
+
+    Allocator *allocator = (Allocator *) memory;
+    allocator->memory = memory;
+    allocator->size = size;
+    allocator->arena_count = 0;
+    allocator->next_arena_size = size;
+    for (size_t i = 0; i < SLAB_CLASSES; i++) {
+        allocator->partial[i] = SLAB_NONE;
+    }
+
+    if (!arena_init(allocator, allocator + 1, size - sizeof(Allocator))) {
+        return NULL;
+    }
+    return allocator;
+}
+
+void allocator_destroy(Allocator *const allocator) {
+    if (allocator == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < allocator->arena_count; i++) {
+        if (allocator->arenas[i].mapped_size != 0) {
+            munmap(allocator->arenas[i].slabs, allocator->arenas[i].mapped_size);
+        }
+    }
+    munmap(allocator->memory, allocator->size);
+}
+
+void *allocator_alloc(Allocator *const allocator, const size_t size) {
+    TRACE_SCOPE("allocator_alloc");
+    if (allocator == NULL || size == 0 || size > REGION_MAX_SIZE) {
+        return NULL;
+    }
+
+    if (size > class_size(SLAB_CLASSES - 1)) {
+        size_t count = (size + SLAB_SIZE - 1) / SLAB_SIZE;
+        uint32_t id = take_run(allocator, count);
+        if (id == SLAB_NONE) {
+            return NULL;
+        }
+        SlabArena *arena = arena_of_id(allocator, id);
+        Slab *slab = &arena->slabs[id - arena->first_id];
+        slab->kind = SLAB_LARGE;
+        slab->run = (uint32_t) count;
+        return arena->base + (size_t) (id - arena->first_id) * SLAB_SIZE;
+    }
+
+    size_t index = class_of(size);
+    uint32_t id = allocator->partial[index];
+    if (id == SLAB_NONE) {
+        id = take_run(allocator, 1);
+        if (id == SLAB_NONE) {
+            return NULL;
+        }
+
+        Slab *slab = slab_of_id(allocator, id);
+        slab->kind = (uint8_t) index;
+        slab->used = 0;
+        memset(slab->bitmap, 0, sizeof(slab->bitmap));
+        // Биты за пределами вместимости слэба считаем занятыми
+        for (size_t bit = class_capacity(index); bit < SLAB_BITMAP_WORDS * 64; bit++) {
+            slab->bitmap[bit / 64] |= (uint64_t) 1 << (bit % 64);
+        }
+        partial_push(allocator, id);
+    }
+
+    SlabArena *arena = arena_of_id(allocator, id);
+    Slab *slab = &arena->slabs[id - arena->first_id];
+    size_t word = 0;
+    while (slab->bitmap[word] == UINT64_MAX) {
+        word++;
+    }
+    size_t bit = word * 64 + (size_t) __builtin_ctzll(~slab->bitmap[word]);
+    slab->bitmap[word] |= (uint64_t) 1 << (bit % 64);
+
+    if (++slab->used == class_capacity(index)) {
+        partial_remove(allocator, id);
+    }
+    return arena->base + (size_t) (id - arena->first_id) * SLAB_SIZE + bit * class_size(index);
+}
+
+void allocator_free(Allocator *const allocator, void *const memory) {
+    TRACE_SCOPE("allocator_free");
+    if (allocator == NULL || memory == NULL) {
+        return;
+    }
+    SlabArena *arena = arena_of_address(allocator, memory);
+    if (arena == NULL) {
+        return;
+    }
+
+    size_t offset = (size_t) ((uint8_t *) memory - arena->base);
+    size_t index = offset / SLAB_SIZE;
+    Slab *slab = &arena->slabs[index];
+
+    if (slab->kind == SLAB_LARGE) {
+        mark_run(arena, index, slab->run, false);
+        slab->kind = SLAB_EMPTY;
+        return;
+    }
+    if (slab->kind == SLAB_EMPTY) {
+        return;
+    }
+
+    size_t bit = offset % SLAB_SIZE / class_size(slab->kind);
+    uint64_t mask = (uint64_t) 1 << (bit % 64);
+    if (!(slab->bitmap[bit / 64] & mask)) {
+        return;
+    }
+    slab->bitmap[bit / 64] &= ~mask;
+
+    uint32_t id = arena->first_id + (uint32_t) index;
+    if (slab->used-- == class_capacity(slab->kind)) {
+        partial_push(allocator, id);
+    }
+    if (slab->used == 0) {
+        // Пустой слэб возвращается в общий пул и может достаться другому классу
+        partial_remove(allocator, id);
+        slab->kind = SLAB_EMPTY;
+        mark_run(arena, index, 1, false);
+    }
+}
+
+size_t allocator_usable_size(Allocator *const allocator, void *const memory) {
+    if (allocator == NULL || memory == NULL) {
+        return 0;
+    }
+    SlabArena *arena = arena_of_address(allocator, memory);
+    if (arena == NULL) {
+        return 0;
+    }
+    Slab *slab = &arena->slabs[(size_t) ((uint8_t *) memory - arena->base) / SLAB_SIZE];
+    if (slab->kind == SLAB_LARGE) {
+        return (size_t) slab->run * SLAB_SIZE;
+    }
+    return class_size(slab->kind);
+}
+
+void *allocator_realloc(Allocator *const allocator, void *const memory, const size_t size) {
+    if (memory == NULL) {
+        return allocator_alloc(allocator, size);
+    }
+
+    size_t available = allocator_usable_size(allocator, memory);
+    if (size <= available) {
+        return memory;
+    }
+
+    void *moved = allocator_alloc(allocator, size);
+    if (moved == NULL) {
+        return NULL;
+    }
+    memcpy(moved, memory, available);
+    allocator_free(allocator, memory);
+    return moved;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "region.h"
+
+#define SLAB_SIZE 4096
+#define SLAB_MIN_OBJECT 8
+#define SLAB_CLASSES 9  // 8, 16, ..., 2048 байт
+#define SLAB_BITMAP_WORDS (SLAB_SIZE / SLAB_MIN_OBJECT / 64)
+#define SLAB_NONE UINT32_MAX
+#define SLAB_MAX_ARENAS 32
+
+enum slab_kind {
+    SLAB_EMPTY = SLAB_CLASSES,
+    SLAB_LARGE
+};
+
+// Описатель слэба хранится отдельно от самих объектов, заголовков у объектов нет
+typedef struct Slab {
+    uint64_t bitmap[SLAB_BITMAP_WORDS];  // 1 - объект занят
+    uint32_t next;
+    uint32_t prev;
+    uint32_t run;  // Для SLAB_LARGE - число подряд идущих слэбов
+    uint16_t used;
+    uint8_t kind;  // Индекс класса или slab_kind
+} Slab;
+
+// Непрерывный участок слэбов: исходная память или область, отображённая при росте.
+// Номера слэбов сквозные: first_id + индекс внутри участка
+typedef struct SlabArena {
+    Slab *slabs;
+    uint64_t *occupied;  // 1 - слэб отдан классу или большому объекту
+    uint8_t *base;
+    size_t num_slabs;
+    uint32_t first_id;
+    size_t mapped_size;  // 0 у исходной памяти, её освобождает allocator_destroy целиком
+} SlabArena;
+
+typedef struct Allocator {
+    void *memory;
+    size_t size;
+    SlabArena arenas[SLAB_MAX_ARENAS];
+    size_t arena_count;
+    size_t next_arena_size;
+    uint32_t partial[SLAB_CLASSES];  // Слэбы класса, в которых есть свободные объекты
+} Allocator;
+
+
+Allocator *allocator_create(void *const memory, const size_t size);
+
+void *allocator_alloc(Allocator *const allocator, const size_t size);
+
+void allocator_free(Allocator *const allocator, void *const memory);
+
+void allocator_destroy(Allocator *const allocator);
+
+void *allocator_realloc(Allocator *const allocator, void *const memory, const size_t size);
+
+size_t allocator_usable_size(Allocator *const allocator, void *const memory);
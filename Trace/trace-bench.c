@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "trace.h"
+
+// Сборка: gcc -O2 -DTRACE_ENABLED -o trace-bench trace-bench.c trace.c -pthread
+//         gcc -O2 -o trace-bench-off trace-bench.c   (макросы пустые - проверка нулевой цены)
+//
+// Меряет цену одного события: пустой цикл против цикла с TRACE_BEGIN/TRACE_END.
+// Отдельно печатается цена одного чтения часов - ниже неё событие с меткой времени не бывает.
+// TRACE_SAMPLE=N ./trace-bench - цена при выборке каждого N-го участка.
+
+#define DEFAULT_ITERATIONS 10000000
+
+static double now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+int main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? atol(argv[1]) : DEFAULT_ITERATIONS;
+    volatile long sink = 0;
+
+    double start = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        sink += i;
+    }
+    double baseline = now_ns() - start;
+
+    start = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        TRACE_BEGIN("iteration");
+        sink += i;
+        TRACE_END("iteration");
+    }
+    double traced = now_ns() - start;
+
+#ifdef TRACE_ENABLED
+    start = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        sink += trace_now();
+    }
+    printf("Clock read: %.2f ns\n", (now_ns() - start - baseline) / iterations);
+#endif
+
+    printf("%s: %.2f ns per event (%ld events)\n",
+#ifdef TRACE_ENABLED
+           "Tracing enabled",
+#else
+           "Tracing compiled out",
+#endif
+           (traced - baseline) / (2.0 * iterations), 2 * iterations);
+    return 0;
+}
@@ -0,0 +1,254 @@
+#ifdef TRACE_ENABLED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "trace.h"
+
+// Кольца выделяются через mmap, а JSON пишется write() из буфера на стеке: трассировка
+// работает и внутри аллокаторов Lab4, в том числе под malloc-shim, не вызывая malloc.
+
+#define TRACE_LINE 256
+#define TRACE_OUTPUT_BUFFER 65536
+
+__thread TraceRing *trace_ring __attribute__((tls_model("initial-exec"))) = NULL;
+
+uint32_t trace_sample = 1;
+
+static TraceRing *trace_rings = NULL;
+static uint64_t start_ticks;
+static struct timespec start_time;
+static int perf_enabled;
+
+static const char *const counter_names[3] = {"cycles", "cache_misses", "context_switches"};
+
+static uint64_t timespec_ns(const struct timespec *time) {
+    return (uint64_t) time->tv_sec * 1000000000u + time->tv_nsec;
+}
+
+static int perf_open(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // Текущий поток на любом процессоре; без прав или PMU (виртуальные машины) вернёт -1
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+static void open_perf(TraceRing *ring) {
+    ring->perf_fds[0] = perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    ring->perf_fds[1] = perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    ring->perf_fds[2] = perf_open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES);
+}
+
+TraceRing *trace_ring_create(void) {
+    TraceRing *ring = mmap(NULL, sizeof(TraceRing), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED) {
+        return NULL;
+    }
+    ring->head = 0;
+    ring->depth = 0;
+    ring->skipping = 0;
+    ring->top_level = 0;
+    ring->tid = (int) syscall(SYS_gettid);
+    ring->perf_fds[0] = ring->perf_fds[1] = ring->perf_fds[2] = -1;
+    if (perf_enabled) {
+        open_perf(ring);
+    }
+
+    // Регистрация без блокировок: кольцо ставится в голову списка
+    ring->next = __atomic_load_n(&trace_rings, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&trace_rings, &ring->next, ring, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+    trace_ring = ring;
+    return ring;
+}
+
+// Решение принимается на участке верхнего уровня и действует на всё вложенное;
+// события вне участков записываются всегда
+int trace_sampled(TraceRing *ring, char phase) {
+    if (phase == TRACE_PHASE_BEGIN) {
+        if (ring->depth++ == 0) {
+            ring->skipping = ring->top_level++ % trace_sample != 0;
+        }
+        return !ring->skipping;
+    }
+    if (phase == TRACE_PHASE_END) {
+        if (ring->depth == 0) {
+            return 1;
+        }
+        ring->depth--;
+        return !ring->skipping;
+    }
+    return ring->depth == 0 || !ring->skipping;
+}
+
+void trace_counters(const char *name) {
+    TraceRing *ring = trace_ring ? trace_ring : trace_ring_create();
+    if (ring == NULL) {
+        return;
+    }
+    trace_event(name, TRACE_PHASE_INSTANT, 0);
+    for (int i = 0; i < 3; i++) {
+        uint64_t value;
+        if (ring->perf_fds[i] != -1 && read(ring->perf_fds[i], &value, sizeof(value)) == sizeof(value)) {
+            trace_event(counter_names[i], TRACE_PHASE_COUNTER, value);
+        }
+    }
+}
+
+// Переводит метку времени события в микросекунды от старта процесса
+static double to_microseconds(uint64_t timestamp, double ns_per_tick) {
+    return (double) (timestamp - start_ticks) * ns_per_tick / 1000.0;
+}
+
+static void flush_output(int fd, char *buffer, size_t *length) {
+    size_t done = 0;
+    while (done < *length) {
+        ssize_t written = write(fd, buffer + done, *length - done);
+        if (written <= 0) {
+            break;
+        }
+        done += written;
+    }
+    *length = 0;
+}
+
+void trace_flush(void) {
+    TraceRing *rings = __atomic_exchange_n(&trace_rings, NULL, __ATOMIC_ACQUIRE);
+    if (rings == NULL) {
+        return;
+    }
+
+    // Калибровка TSC по монотонным часам за всё время работы
+    struct timespec end_time;
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    uint64_t end_ticks = trace_now();
+    double elapsed_ns = (double) (timespec_ns(&end_time) - timespec_ns(&start_time));
+    double ns_per_tick = end_ticks > start_ticks && elapsed_ns > 0 ? elapsed_ns / (end_ticks - start_ticks) : 1.0;
+
+    // %d в имени заменяется на pid, чтобы родитель и дети после fork писали разные файлы
+    char path[TRACE_LINE];
+    const char *pattern = getenv("TRACE_FILE");
+    if (pattern == NULL || pattern[0] == '\0') {
+        pattern = "trace-%d.json";
+    }
+    const char *mark = strstr(pattern, "%d");
+    if (mark != NULL) {
+        snprintf(path, sizeof(path), "%.*s%d%s", (int) (mark - pattern), pattern, (int) getpid(), mark + 2);
+    } else {
+        snprintf(path, sizeof(path), "%s", pattern);
+    }
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        return;
+    }
+
+    char buffer[TRACE_OUTPUT_BUFFER];
+    size_t length = 0;
+    int pid = (int) getpid();
+    int first = 1;
+    length += snprintf(buffer, sizeof(buffer), "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"sample\":%u},\"traceEvents\":[\n",
+                       (unsigned) trace_sample);
+
+    for (TraceRing *ring = rings; ring != NULL; ring = ring->next) {
+        uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        uint64_t start = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+
+        for (uint64_t i = start; i < head; i++) {
+            TraceEvent *event = &ring->events[i & (TRACE_RING_EVENTS - 1)];
+            if (length + TRACE_LINE > sizeof(buffer)) {
+                flush_output(fd, buffer, &length);
+            }
+
+            const char *separator = first ? "" : ",\n";
+            double ts = to_microseconds(event->timestamp, ns_per_tick);
+            first = 0;
+            if (event->phase == TRACE_PHASE_COUNTER) {
+                length += snprintf(buffer + length, sizeof(buffer) - length,
+                                   "%s{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d,"
+                                   "\"args\":{\"%s\":%llu}}",
+                                   separator, event->name, ts, pid, ring->tid, event->name,
+                                   (unsigned long long) event->value);
+            } else if (event->phase == TRACE_PHASE_INSTANT) {
+                length += snprintf(buffer + length, sizeof(buffer) - length,
+                                   "%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d,"
+                                   "\"args\":{\"value\":%llu}}",
+                                   separator, event->name, ts, pid, ring->tid, (unsigned long long) event->value);
+            } else {
+                length += snprintf(buffer + length, sizeof(buffer) - length,
+                                   "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}", separator,
+                                   event->name, (char) event->phase, ts, pid, ring->tid);
+            }
+        }
+    }
+
+    length += snprintf(buffer + length, sizeof(buffer) - length, "\n]}\n");
+    flush_output(fd, buffer, &length);
+    close(fd);
+}
+
+static void close_perf(TraceRing *ring) {
+    for (int i = 0; i < 3; i++) {
+        if (ring->perf_fds[i] != -1) {
+            close(ring->perf_fds[i]);
+            ring->perf_fds[i] = -1;
+        }
+    }
+}
+
+// События родителя попадут только в файл родителя. В ребёнке жив один поток: его кольцо
+// очищается и остаётся единственным в списке, кольца остальных потоков родителя отображаются обратно
+static void trace_forked(void) {
+    TraceRing *ring = trace_rings;
+    while (ring != NULL) {
+        TraceRing *next = ring->next;
+        close_perf(ring);  // Счётчики считали поток родителя
+        if (ring != trace_ring) {
+            munmap(ring, sizeof(TraceRing));
+        }
+        ring = next;
+    }
+
+    trace_rings = trace_ring;
+    if (trace_ring != NULL) {
+        trace_ring->next = NULL;
+        trace_ring->head = 0;
+        trace_ring->depth = 0;
+        trace_ring->skipping = 0;
+        trace_ring->tid = (int) syscall(SYS_gettid);
+        if (perf_enabled) {
+            open_perf(trace_ring);
+        }
+    }
+}
+
+__attribute__((constructor)) static void trace_start(void) {
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    start_ticks = trace_now();
+    const char *perf = getenv("TRACE_PERF");
+    perf_enabled = perf != NULL && perf[0] == '1';
+    const char *sample = getenv("TRACE_SAMPLE");
+    if (sample != NULL && atol(sample) > 1) {
+        trace_sample = (uint32_t) atol(sample);
+    }
+    pthread_atfork(NULL, NULL, trace_forked);
+}
+
+// Деструктор, а не atexit: у Lab4 трассировка живёт в .so, которую main выгружает через dlclose
+__attribute__((destructor)) static void trace_stop(void) {
+    trace_flush();
+}
+
+#endif
@@ -0,0 +1,133 @@
+#pragma once
+
+// Встроенная трассировка горячих участков для всех лабораторных.
+//
+// Сборка с -DTRACE_ENABLED и trace.c включает запись; без флага все макросы раскрываются
+// в пустые выражения и ничего не стоят. Каждый поток пишет события в своё кольцо
+// (единственный писатель, без блокировок); кольца регистрируются в общем списке через CAS
+// и выживают после завершения потока. При выходе из процесса (или выгрузке .so) всё
+// сбрасывается в JSON формата Chrome trace (chrome://tracing, ui.perfetto.dev):
+// файл из переменной TRACE_FILE (%d заменяется на pid) или trace-<pid>.json.
+//
+// TRACE_PERF=1 дополнительно открывает perf_event_open-счётчики потока (такты, промахи кэша,
+// переключения контекста). Их чтение - системные вызовы, поэтому TRACE_COUNTERS ставится
+// на границы крупных участков, а не на каждое событие.
+//
+// TRACE_SAMPLE=N записывает только каждый N-й участок верхнего уровня вместе со всем вложенным.
+// Основная цена события - чтение TSC (в виртуальной машине rdtsc стоит ~20 нс), и без выборки
+// её не убрать; пропущенный участок стоит пару наносекунд.
+//
+// Имена событий - строковые литералы: в кольце хранится только указатель.
+
+#define TRACE_RING_EVENTS (1 << 16)  // Степень двойки; старые события перезаписываются
+
+#ifdef TRACE_ENABLED
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+enum trace_phase {
+    TRACE_PHASE_BEGIN = 'B',
+    TRACE_PHASE_END = 'E',
+    TRACE_PHASE_INSTANT = 'i',
+    TRACE_PHASE_COUNTER = 'C'
+};
+
+typedef struct TraceEvent {
+    uint64_t timestamp;  // Такты TSC или наносекунды, переводятся в микросекунды при сбросе
+    const char *name;
+    uint64_t value;  // Значение счётчика или аргумент события
+    uint64_t phase;
+} TraceEvent;
+
+typedef struct TraceRing {
+    uint64_t head;  // Всего записано событий
+    struct TraceRing *next;
+    int tid;
+    int perf_fds[3];
+    uint32_t depth;  // Вложенность открытых участков - для выборки
+    uint32_t skipping;  // Текущий участок верхнего уровня не попал в выборку
+    uint64_t top_level;  // Участков верхнего уровня начато
+    TraceEvent events[TRACE_RING_EVENTS];
+} TraceRing;
+
+// initial-exec: в .so, загруженной через dlopen, обычная модель TLS выделяет память через malloc
+// при первом обращении, а под malloc-shim это рекурсия в аллокатор
+extern __thread TraceRing *trace_ring __attribute__((tls_model("initial-exec")));
+extern uint32_t trace_sample;  // 1 - записывать всё
+
+TraceRing *trace_ring_create(void);
+int trace_sampled(TraceRing *ring, char phase);
+void trace_counters(const char *name);
+void trace_flush(void);
+
+static inline uint64_t trace_now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000u + now.tv_nsec;
+#endif
+}
+
+static inline void trace_event(const char *name, char phase, uint64_t value) {
+    TraceRing *ring = trace_ring;
+    if (__builtin_expect(ring == NULL, 0)) {
+        ring = trace_ring_create();
+        if (ring == NULL) {
+            return;
+        }
+    }
+    if (__builtin_expect(trace_sample > 1, 0) && !trace_sampled(ring, phase)) {
+        return;
+    }
+    // Писатель у кольца один: без барьера, сброс в конце увидит не больше одного недописанного события
+    uint64_t head = ring->head;
+    TraceEvent *event = &ring->events[head & (TRACE_RING_EVENTS - 1)];
+    event->timestamp = trace_now();
+    event->name = name;
+    event->value = value;
+    event->phase = (unsigned char) phase;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELAXED);
+}
+
+typedef struct TraceScope {
+    const char *name;
+} TraceScope;
+
+static inline void trace_scope_end(TraceScope *scope) {
+    trace_event(scope->name, TRACE_PHASE_END, 0);
+}
+
+static inline TraceScope trace_scope_begin(const char *name) {
+    trace_event(name, TRACE_PHASE_BEGIN, 0);
+    TraceScope scope = {name};
+    return scope;
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#define TRACE_BEGIN(name) trace_event((name), TRACE_PHASE_BEGIN, 0)
+#define TRACE_END(name) trace_event((name), TRACE_PHASE_END, 0)
+#define TRACE_INSTANT(name, value) trace_event((name), TRACE_PHASE_INSTANT, (value))
+// Участок до конца блока, включая все return (расширение GCC/Clang cleanup)
+#define TRACE_SCOPE(name) \
+    TraceScope TRACE_CONCAT(trace_scope_, __LINE__) __attribute__((cleanup(trace_scope_end))) = trace_scope_begin(name)
+#define TRACE_COUNTERS(name) trace_counters(name)
+
+#else
+
+#define TRACE_BEGIN(name) ((void) 0)
+#define TRACE_END(name) ((void) 0)
+#define TRACE_INSTANT(name, value) ((void) 0)
+#define TRACE_SCOPE(name) ((void) 0)
+#define TRACE_COUNTERS(name) ((void) 0)
+
+#endif